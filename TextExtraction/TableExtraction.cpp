@@ -10,6 +10,12 @@
 #include "./lib/graphic-content-parsing/GraphicContentInterpreter.h"
 #include "./lib/table-csv-export/TableCSVExport.h"
 #include "./lib/table-composition/TableComposer.h"
+#include "./lib/text-composition/ParallelPageComposer.h"
+#include "./lib/output/OStreamOutputSink.h"
+#include "./lib/math/Transformations.h"
+
+#include <vector>
+#include <memory>
 
 
 
@@ -21,50 +27,95 @@ TableExtraction::TableExtraction():
     textInterpeter(this), 
     tableLineInterpreter(this)
 {
-
+    fontPrefetchWorkersCount = 0;
+    compositionWorkersCount = 0;
+    textDecoding = eTextDecodingAllPages;
+    interpretationPhase = eInterpretationPhaseAll;
+    pageTablesHandler = NULL;
+    shouldKeepPageTexts = false;
+#ifdef SHOULD_PARSE_INTERNAL_TABLES
+    shouldParseInternalTables = true;
+#else // SHOULD_PARSE_INTERNAL_TABLES
+    shouldParseInternalTables = false;
+#endif
 }
     
 TableExtraction::~TableExtraction() {
-    textsForPages.clear();
-    tableLinesForPages.clear();
     tablesForPages.clear();
-    mediaBoxesForPages.clear();
+    textsForPages.clear();
 }
 
 bool TableExtraction::OnParsedHorizontalLinePlacementComplete(const ParsedLinePlacement& inParsedLine) {
-    tableLinesForPages.back().horizontalLines.push_back(inParsedLine);
+    pageLines.horizontalLines.push_back(inParsedLine);
     return true;
 }
 
 bool TableExtraction::OnParsedVerticalLinePlacementComplete(const ParsedLinePlacement& inParsedLine) {
-    tableLinesForPages.back().verticalLines.push_back(inParsedLine);
+    pageLines.verticalLines.push_back(inParsedLine);
     return true;
 }
 
 
 bool TableExtraction::OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement) {
-    textsForPages.back().push_back(inParsedTextPlacement);
+    pageTexts->Add(inParsedTextPlacement);
+    // the page texts, same as text extraction filters them, for when text is extracted along with the tables
+    if(shouldKeepPageTexts && DoBoxesIntersect(currentPageScopeBox, inParsedTextPlacement.globalBbox))
+        textsForPages.back().Add(inParsedTextPlacement);
     return true;
 }
 
 
+bool TableExtraction::ShouldDecodeTextPlacement(const double (&inGlobalBbox)[4]) {
+    if(textDecoding != eTextDecodingTableRegions)
+        return true;
+
+    // same test as for texts and tables boxes when composing, so NaN boxes are not ruled out
+    TableCandidateBoxVector::const_iterator it = pageTableCandidates.begin();
+    for(; it != pageTableCandidates.end(); ++it) {
+        if(!(inGlobalBbox[3] < it->box[1]) && 
+            !(inGlobalBbox[1] > it->box[3]) && 
+            !(inGlobalBbox[0] > it->box[2]) && 
+            !(inGlobalBbox[2] < it->box[0]))
+            return true;
+    }
+    return false;
+}
+
 bool TableExtraction::OnTextElementComplete(const TextElement& inTextElement) {
+    if(interpretationPhase == eInterpretationPhaseLines)
+        return true;
     return textInterpeter.OnTextElementComplete(inTextElement);
 }
 
 bool TableExtraction::OnPathPainted(const PathElement& inPathElement) {
+    if(interpretationPhase == eInterpretationPhaseTexts)
+        return true;
     return tableLineInterpreter.OnPathPainted(inPathElement);
 }
 
 bool TableExtraction::OnResourcesRead(const Resources& inResources, IInterpreterContext* inContext) {
+    // fonts are only needed when there's text to decode
+    if(interpretationPhase == eInterpretationPhaseLines)
+        return true;
     return textInterpeter.OnResourcesRead(inResources, inContext);
 }
 
-EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long inStartPage, long inEndPage) {
+void TableExtraction::InterpretPage(PDFParser* inParser, PDFDictionary* inPage, EInterpretationPhase inPhase) {
+    interpretationPhase = inPhase;
+
+    // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements.
+    // it allocates from the page arena, so it's created per page and gone before the arena is released
+    {
+        GraphicContentInterpreter interpreter(pageArena.GetResource());
+        interpreter.InterpretPageContents(inParser, inPage, this);
+    }
+    pageArena.EndPage();
+}
+
+EStatusCode TableExtraction::ExtractPagesTables(PDFParser* inParser, long inStartPage, long inEndPage, FontDecoderPrefetcher* inPrefetcher) {
     EStatusCode status = eSuccess;
     unsigned long start = (unsigned long)(inStartPage >= 0 ? inStartPage : (inParser->GetPagesCount() + inStartPage));
     unsigned long end = (unsigned long)(inEndPage >= 0 ? inEndPage :  (inParser->GetPagesCount() + inEndPage));
-    GraphicContentInterpreter interpreter;
 
 
     if(end > inParser->GetPagesCount()-1)
@@ -72,7 +123,14 @@ EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long in
     if(start > end)
         start = end;
 
-    for(unsigned long i=start;i<=end && status == eSuccess;++i) {
+    if(inPrefetcher) {
+        inPrefetcher->Start(start, end);
+        textInterpeter.SetFontDecoderPrefetcher(inPrefetcher);
+    }
+    textInterpeter.SetMemoryResource(pageArena.GetResource());
+
+    bool shouldContinue = true;
+    for(unsigned long i=start;i<=end && status == eSuccess && shouldContinue;++i) {
         RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(i));
         if(!pageObject) {
             status = eFailure;
@@ -80,14 +138,41 @@ EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long in
         }
 
         PDFPageInput pageInput(inParser,pageObject);
+        PDFRectangle mediaBox = pageInput.GetMediaBox();
+
+        currentPageScopeBox[0] = mediaBox.LowerLeftX;
+        currentPageScopeBox[1] = mediaBox.LowerLeftY;
+        currentPageScopeBox[2] = mediaBox.UpperRightX;
+        currentPageScopeBox[3] = mediaBox.UpperRightY;
+
+        pageTexts = make_shared<ParsedTextPlacementList>();
+        pageLines = Lines();
+        if(shouldKeepPageTexts)
+            textsForPages.push_back(ParsedTextPlacementList());
+
+        if(textDecoding == eTextDecodingAllPages) {
+            InterpretPage(inParser, pageObject.GetPtr(), eInterpretationPhaseAll);
+        }
+        else {
+            // two phases. lines first, and texts only if the lines may form tables
+            InterpretPage(inParser, pageObject.GetPtr(), eInterpretationPhaseLines);
 
-        mediaBoxesForPages.push_back(pageInput.GetMediaBox());
-        textsForPages.push_back(ParsedTextPlacementList());
-        tableLinesForPages.push_back(Lines());
-        // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements
-        interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);  
+            tableComposer.FindTableCandidatesBoxes(pageLines, currentPageScopeBox, pageTableCandidates);
+            if(pageTableCandidates.size() > 0)
+                InterpretPage(inParser, pageObject.GetPtr(), eInterpretationPhaseTexts);
+        }
+
+        // tables don't span pages, so compose this page tables now, and let go of the page data
+        shouldContinue = ComposePageTables(i, mediaBox);
     }    
 
+    interpretationPhase = eInterpretationPhaseAll;
+    pageTableCandidates.clear();
+    pageTexts.reset();
+    pageLines = Lines();
+
+    textInterpeter.SetFontDecoderPrefetcher(NULL);
+    textInterpeter.SetMemoryResource(NULL);
     textInterpeter.ResetInterpretationState();
 
     return status;
@@ -95,12 +180,39 @@ EStatusCode TableExtraction::ExtractTablePlacements(PDFParser* inParser, long in
 
 static const string scEmpty = "";
 
+void TableExtraction::SetFontPrefetchWorkers(unsigned int inWorkersCount) {
+    fontPrefetchWorkersCount = inWorkersCount;
+}
+
+void TableExtraction::SetCompositionWorkers(unsigned int inWorkersCount) {
+    compositionWorkersCount = inWorkersCount;
+}
+
+void TableExtraction::SetShouldParseInternalTables(bool inShouldParseInternalTables) {
+    shouldParseInternalTables = inShouldParseInternalTables;
+}
+
+void TableExtraction::SetTextDecoding(ETextDecoding inTextDecoding) {
+    textDecoding = inTextDecoding;
+}
+
+void TableExtraction::SetPageTablesHandler(IPageTablesHandler* inHandler) {
+    pageTablesHandler = inHandler;
+}
+
+void TableExtraction::SetShouldKeepPageTexts(bool inShouldKeepPageTexts) {
+    shouldKeepPageTexts = inShouldKeepPageTexts;
+}
+
+const PageArenaStats& TableExtraction::GetPageArenaStats() const {
+    return pageArena.GetStats();
+}
+
 void TableExtraction::ClearState() {
-    textsForPages.clear();
-    tableLinesForPages.clear();
     tablesForPages.clear();
-    mediaBoxesForPages.clear();
+    textsForPages.clear();
     LatestWarnings.clear();
+    pageArena.ResetStats();
     LatestError.code = eErrorNone;
     LatestError.description = scEmpty;
 }
@@ -129,11 +241,13 @@ EStatusCode TableExtraction::ExtractTables(const std::string& inFilePath, long i
             break;
         }
 
-        status = ExtractTablePlacements(&parser, inStartPage, inEndPage);
-        if(status != eSuccess)
-            break;
-
-        ComposeTables();
+        if(fontPrefetchWorkersCount > 0) {
+            FontDecoderPrefetcher prefetcher(inFilePath, fontPrefetchWorkersCount);
+            status = ExtractPagesTables(&parser, inStartPage, inEndPage, &prefetcher);
+        }
+        else {
+            status = ExtractPagesTables(&parser, inStartPage, inEndPage);
+        }
     } while(false);
 
     return status;
@@ -142,12 +256,7 @@ EStatusCode TableExtraction::ExtractTables(const std::string& inFilePath, long i
 PDFHummus::EStatusCode TableExtraction::ExtractTables(PDFParser* inParser, long inStartPage, long inEndPage) {
     ClearState();
 
-    PDFHummus::EStatusCode status = ExtractTablePlacements(inParser, inStartPage, inEndPage);
-    if(status == eSuccess) {
-        ComposeTables();
-    }
-
-    return status;
+    return ExtractPagesTables(inParser, inStartPage, inEndPage);
 }
 
 PDFHummus::EStatusCode TableExtraction::ExtractTables(IByteReaderWithPosition* inStream, long inStartPage, long inEndPage)  {
@@ -165,11 +274,7 @@ PDFHummus::EStatusCode TableExtraction::ExtractTables(IByteReaderWithPosition* i
             break;
         }
 
-        status = ExtractTablePlacements(&parser, inStartPage, inEndPage);
-        if(status != eSuccess)
-            break;
-
-        ComposeTables();
+        status = ExtractPagesTables(&parser, inStartPage, inEndPage);
     } while(false);
 
     return status;    
@@ -177,20 +282,21 @@ PDFHummus::EStatusCode TableExtraction::ExtractTables(IByteReaderWithPosition* i
 
 
 
-void TableExtraction::ComposeTables() {
-    TableComposer tableComposer;
-    ParsedTextPlacementListList::iterator itTextsforPages = textsForPages.begin();
-    LinesList::iterator itTablesLinesForPages = tableLinesForPages.begin();
-    PDFRectangleList::iterator itMediaBoxForPages = mediaBoxesForPages.begin();
+bool TableExtraction::ComposePageTables(unsigned long inPageIndex, const PDFRectangle& inMediaBox) {
+    tableComposer.SetShouldParseInternalTables(shouldParseInternalTables);
 
-    // iterate the pages (lists are supposed to be synced)
-    for(; itTextsforPages != textsForPages.end() &&  
-            itTablesLinesForPages != tableLinesForPages.end() && 
-            itMediaBoxForPages != mediaBoxesForPages.end(); 
-            ++itTextsforPages, ++itTablesLinesForPages, ++itMediaBoxForPages) {
-        double pageScopeBox[4] ={itMediaBoxForPages->LowerLeftX, itMediaBoxForPages->LowerLeftY, itMediaBoxForPages->UpperRightX, itMediaBoxForPages->UpperRightY};
-        tablesForPages.push_back(tableComposer.ComposeTables(*itTablesLinesForPages, *itTextsforPages, pageScopeBox));
-    }
+    double pageScopeBox[4] ={inMediaBox.LowerLeftX, inMediaBox.LowerLeftY, inMediaBox.UpperRightX, inMediaBox.UpperRightY};
+    TableList tables = tableComposer.ComposeTables(pageLines, pageTexts, pageScopeBox);
+
+    // the tables hold on to the page texts, if they need them. the page texts and lines can go now
+    pageTexts.reset();
+    pageLines = Lines();
+
+    if(pageTablesHandler)
+        return pageTablesHandler->OnPageTablesComposed(inPageIndex, tables);
+
+    tablesForPages.push_back(move(tables));
+    return true;
 }
 
 static const string scCRLN = "\r\n";
@@ -200,21 +306,91 @@ void TableExtraction::GetTableAsCSVText(const Table& inTable, int bidiFlag, Text
     exporter.ComposeTableText(inTable, outStream);
 }
 
-void TableExtraction::GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream) {
+void TableExtraction::GetTableAsCSVText(const Table& inTable, int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer) {
     TableCSVExport exporter(bidiFlag, spacingFlag);
+    exporter.ComposeTableText(inTable, outBuffer);
+}
 
-    TableListList::iterator itPages = tablesForPages.begin();
+typedef vector<const TableList*> TableListPtrVector;
+typedef vector<unique_ptr<TableCSVExport> > TableCSVExportVector;
 
-    for(; itPages != tablesForPages.end(); ++itPages) {
-        TableList::iterator itTables = itPages->begin();
-        for(; itTables != itPages->end(); ++itTables) {
-            exporter.ComposeTableText(*itTables, outStream);
-            outStream<<scCRLN; // two newlines to separate tables on the same page
-            outStream<<scCRLN;
-        }
-        outStream<<scCRLN; // 4 newlines to separate pages
-        outStream<<scCRLN;
-        outStream<<scCRLN;
-        outStream<<scCRLN;
-    }
+void TableExtraction::GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream) {
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
+
+    GetAllAsCSVText(bidiFlag, spacingFlag, buffer);
+}
+
+void TableExtraction::GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer) {
+    ParallelPageComposer pageComposer(compositionWorkersCount);
+
+    // index the pages, for the workers to pick from
+    TableListPtrVector pages;
+    TableListList::const_iterator itPages = tablesForPages.begin();
+    for(; itPages != tablesForPages.end(); ++itPages)
+        pages.push_back(&(*itPages));
+
+    // exporters hold a text composer, so one per worker
+    TableCSVExportVector exporters;
+    for(unsigned int i=0;i<pageComposer.GetWorkersCount(pages.size());++i)
+        exporters.push_back(unique_ptr<TableCSVExport>(new TableCSVExport(bidiFlag, spacingFlag)));
+
+    pageComposer.Compose(
+        pages.size(),
+        [&pages, &exporters](size_t inPageIndex, size_t inWorkerIndex, OutputBuffer& outPageBuffer) {
+            TableList::const_iterator itTables = pages[inPageIndex]->begin();
+            for(; itTables != pages[inPageIndex]->end(); ++itTables) {
+                exporters[inWorkerIndex]->ComposeTableText(*itTables, outPageBuffer);
+                WriteTableSeparator(outPageBuffer);
+            }
+            WritePageSeparator(outPageBuffer);
+        },
+        outBuffer
+    );
+}
+
+void TableExtraction::WriteTableSeparator(OutputBuffer& outBuffer) {
+    outBuffer.Append(scCRLN); // two newlines to separate tables on the same page
+    outBuffer.Append(scCRLN);
+}
+
+void TableExtraction::WritePageSeparator(OutputBuffer& outBuffer) {
+    outBuffer.Append(scCRLN); // 4 newlines to separate pages
+    outBuffer.Append(scCRLN);
+    outBuffer.Append(scCRLN);
+    outBuffer.Append(scCRLN);
+}
+
+void TableExtraction::GetAllAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream) {
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
+
+    GetAllAsText(bidiFlag, spacingFlag, buffer);
+}
+
+typedef vector<const ParsedTextPlacementList*> ParsedTextPlacementListPtrVector;
+typedef vector<unique_ptr<TextComposer> > TextComposerVector;
+
+void TableExtraction::GetAllAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer) {
+    ParallelPageComposer pageComposer(compositionWorkersCount);
+
+    // index the pages, for the workers to pick from
+    ParsedTextPlacementListPtrVector pages;
+    ParsedTextPlacementListList::const_iterator itPages = textsForPages.begin();
+    for(; itPages != textsForPages.end();++itPages)
+        pages.push_back(&(*itPages));
+
+    // composers keep line buffers and bidi state, so one per worker
+    TextComposerVector composers;
+    for(unsigned int i=0;i<pageComposer.GetWorkersCount(pages.size());++i)
+        composers.push_back(unique_ptr<TextComposer>(new TextComposer(bidiFlag, spacingFlag)));
+
+    pageComposer.Compose(
+        pages.size(),
+        [&pages, &composers](size_t inPageIndex, size_t inWorkerIndex, OutputBuffer& outPageBuffer) {
+            composers[inWorkerIndex]->ComposeText(*pages[inPageIndex], outPageBuffer);
+            outPageBuffer.Append(scCRLN);
+        },
+        outBuffer
+    );
 }
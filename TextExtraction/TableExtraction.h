@@ -12,24 +12,48 @@
 #include "./lib/table-line-parsing/ITableLineInterpreterHandler.h"
 #include "./lib/table-composition/Lines.h"
 #include "./lib/table-composition/Table.h"
+#include "./lib/table-composition/TableComposer.h"
+#include "./lib/table-composition/IPageTablesHandler.h"
+#include "./lib/memory/PageArena.h"
+#include "./lib/output/OutputBuffer.h"
 
 #include "ErrorsAndWarnings.h"
 
 class PDFParser;
+class PDFDictionary;
 class IByteReaderWithPosition;
 
 #include <sstream>
 #include <string>
 #include <list>
+#include <memory>
 
 typedef std::list<ParsedTextPlacementList> ParsedTextPlacementListList;
 typedef std::list<TableList> TableListList;
 typedef std::list<ExtractionWarning> ExtractionWarningList;
 typedef std::list<PDFRectangle> PDFRectangleList;
 
+/**
+ * Threading contract is the same as TextExtraction's - an object serves one thread at a time, as ExtractTables
+ * keeps the current page texts and lines in it till its tables are composed. Different objects may run concurrently.
+ * Tables are composed page by page, right after each page is interpreted. They are collected in tablesForPages, or
+ * passed to a handler (SetPageTablesHandler) - in which case memory use doesn't grow with the document.
+ * With SetShouldKeepPageTexts the pages texts are kept in textsForPages as well, so text and tables come out of a single
+ * interpretation of the document, instead of running TextExtraction over it too.
+ * GetTableAsCSVText and GetAllAsCSVText only read the results, so once extraction is done they can be called from several threads.
+ */
 class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpreterHandler, ITableLineInterpreterHandler {
 
     public:
+        enum ETextDecoding {
+            // decode the text of all pages, along with their lines (one pass per page)
+            eTextDecodingAllPages = 0,
+            // first go through a page lines, and decode its text only if it has groups of lines that may form tables
+            eTextDecodingTablePages = 1,
+            // same, and only decode texts that intersect these groups of lines
+            eTextDecodingTableRegions = 2
+        };
+
         TableExtraction();
         virtual ~TableExtraction();
 
@@ -37,10 +61,38 @@ class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpret
         PDFHummus::EStatusCode ExtractTables(PDFParser* inParser, long inStartPage=0, long inEndPage=-1);
         PDFHummus::EStatusCode ExtractTables(IByteReaderWithPosition* inStream, long inStartPage=0, long inEndPage=-1);
 
+        // when extracting from a file, build the document fonts ahead of time with this many worker threads.
+        // 0 (the default) parses fonts when first met by the interpreter
+        void SetFontPrefetchWorkers(unsigned int inWorkersCount);
+
+        // compose the tables of pages on this many worker threads in GetAllAsCSVText. the output is the same as when
+        // composing on the calling thread, which is what happens with 0 or 1 (the default)
+        void SetCompositionWorkers(unsigned int inWorkersCount);
+
+        // parse split cells into internal tables of their cells (CellInRow::internalTable). CSV output doesn't use them, so
+        // it's off by default, unless built with SHOULD_PARSE_INTERNAL_TABLES
+        void SetShouldParseInternalTables(bool inShouldParseInternalTables);
+
+        // which texts to decode. tables are the same either way, but with pages without tables the two phases modes
+        // skip most of the text decoding. pages with tables have their content interpreted twice. default is eTextDecodingAllPages
+        void SetTextDecoding(ETextDecoding inTextDecoding);
+
+        // pass each page tables to inHandler once composed, instead of collecting them in tablesForPages (so GetAllAsCSVText
+        // will have nothing to write). NULL to collect them (the default)
+        void SetPageTablesHandler(IPageTablesHandler* inHandler);
+
+        // also keep the pages texts in textsForPages, same as TextExtraction::ExtractText would. off by default.
+        // pages texts are only complete with eTextDecodingAllPages, the other modes skip texts that can't be in tables
+        void SetShouldKeepPageTexts(bool inShouldKeepPageTexts);
+
+        // page interpretation temporaries are allocated from a per page arena. these are its counters for the latest extraction
+        const PageArenaStats& GetPageArenaStats() const;
+
         ExtractionError LatestError;
         ExtractionWarningList LatestWarnings;  
 
         TableListList tablesForPages;
+        ParsedTextPlacementListList textsForPages;
 
         // IGraphicContentInterpreterHandler implementation
         virtual bool OnTextElementComplete(const TextElement& inTextElement);
@@ -49,25 +101,57 @@ class TableExtraction : public ITextInterpreterHandler, IGraphicContentInterpret
 
         // ITextInterpreterHandler implementation
         virtual bool OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement); 
+        virtual bool ShouldDecodeTextPlacement(const double (&inGlobalBbox)[4]);
 
         // ITableLineInterpreterHandler implementation
         virtual bool OnParsedHorizontalLinePlacementComplete(const ParsedLinePlacement& inParsedLine); 
         virtual bool OnParsedVerticalLinePlacementComplete(const ParsedLinePlacement& inParsedLine); 
 
         void GetTableAsCSVText(const Table& inTable, int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream);
+        // write to an output buffer. it is not flushed, so call Flush on it when done
+        void GetTableAsCSVText(const Table& inTable, int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer);
         void GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream);
+        void GetAllAsCSVText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer);
+        // GetAllAsCSVText follows each table with a table separator, and each page with a page separator. these write them, to lay out
+        // tables composed one by one the same way
+        static void WriteTableSeparator(OutputBuffer& outBuffer);
+        static void WritePageSeparator(OutputBuffer& outBuffer);
+        // text of the pages kept with SetShouldKeepPageTexts, same as TextExtraction::GetResultsAsText writes it.
+        // the output buffer is not flushed, so call Flush on it when done
+        void GetAllAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream);
+        void GetAllAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer);
 
     private:
         TextInterpeter textInterpeter;
+        unsigned int fontPrefetchWorkersCount;
+        unsigned int compositionWorkersCount;
+        bool shouldParseInternalTables;
+        bool shouldKeepPageTexts;
+        ETextDecoding textDecoding;
+        PageArena pageArena;
         TableLineInterpreter tableLineInterpreter;
 
-        ParsedTextPlacementListList textsForPages;
-        LinesList tableLinesForPages;
-        PDFRectangleList mediaBoxesForPages;
+        IPageTablesHandler* pageTablesHandler;
+
+        // current page texts and lines. the texts are shared with the page tables, whose cells refer to them
+        std::shared_ptr<ParsedTextPlacementList> pageTexts;
+        Lines pageLines;
+        double currentPageScopeBox[4];
+
+        // page interpretation phase, for the two phases text decoding modes
+        enum EInterpretationPhase {
+            eInterpretationPhaseAll,
+            eInterpretationPhaseLines,
+            eInterpretationPhaseTexts
+        };
+        EInterpretationPhase interpretationPhase;
+        TableComposer tableComposer;
+        TableCandidateBoxVector pageTableCandidates;
 
 
-        PDFHummus::EStatusCode ExtractTablePlacements(PDFParser* inParser, long inStartPage, long inEndPage);
-        void ComposeTables();
+        PDFHummus::EStatusCode ExtractPagesTables(PDFParser* inParser, long inStartPage, long inEndPage, FontDecoderPrefetcher* inPrefetcher = NULL);
+        void InterpretPage(PDFParser* inParser, PDFDictionary* inPage, EInterpretationPhase inPhase);
+        bool ComposePageTables(unsigned long inPageIndex, const PDFRectangle& inMediaBox);
         void ClearState();
         
 };
\ No newline at end of file
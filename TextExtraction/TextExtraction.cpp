@@ -8,12 +8,18 @@
 #include "./lib/interpreter/PDFRecursiveInterpreter.h"
 #include "./lib/graphic-content-parsing/GraphicContentInterpreter.h"
 #include "./lib/math/Transformations.h"
+#include "./lib/output/OStreamOutputSink.h"
+#include "./lib/text-composition/ParallelPageComposer.h"
+
+#include <vector>
+#include <memory>
 
 using namespace std;
 using namespace PDFHummus;
 
 TextExtraction::TextExtraction():textInterpeter(this) {
-
+    fontPrefetchWorkersCount = 0;
+    compositionWorkersCount = 0;
 }
     
 TextExtraction::~TextExtraction() {
@@ -23,7 +29,7 @@ TextExtraction::~TextExtraction() {
 bool TextExtraction::OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement) {
     // filter out elements outside of the page box
     if(DoBoxesIntersect(currentPageScopeBox, inParsedTextPlacement.globalBbox))
-        textsForPages.back().push_back(inParsedTextPlacement);
+        textsForPages.back().Add(inParsedTextPlacement);
     return true;
 }
 
@@ -42,11 +48,10 @@ bool TextExtraction::OnResourcesRead(const Resources& inResources, IInterpreterC
     return textInterpeter.OnResourcesRead(inResources, inContext);
 }
 
-EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage) {
+EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage, FontDecoderPrefetcher* inPrefetcher) {
     EStatusCode status = eSuccess;
     unsigned long start = (unsigned long)(inStartPage >= 0 ? inStartPage : (inParser->GetPagesCount() + inStartPage));
     unsigned long end = (unsigned long)(inEndPage >= 0 ? inEndPage :  (inParser->GetPagesCount() + inEndPage));
-    GraphicContentInterpreter interpreter;
 
 
     if(end > inParser->GetPagesCount()-1)
@@ -54,6 +59,12 @@ EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inSt
     if(start > end)
         start = end;
 
+    if(inPrefetcher) {
+        inPrefetcher->Start(start, end);
+        textInterpeter.SetFontDecoderPrefetcher(inPrefetcher);
+    }
+    textInterpeter.SetMemoryResource(pageArena.GetResource());
+
     for(unsigned long i=start;i<=end && status == eSuccess;++i) {
         RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(i));
         if(!pageObject) {
@@ -69,13 +80,20 @@ EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inSt
         currentPageScopeBox[3] = mediaBox.UpperRightY;
 
         textsForPages.push_back(ParsedTextPlacementList());
-        // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements
-        interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);
+        // the interpreter will trigger the textInterpreter which in turn will trigger this object to collect text elements.
+        // it allocates from the page arena, so it's created per page and gone before the arena is released
+        {
+            GraphicContentInterpreter interpreter(pageArena.GetResource());
+            interpreter.InterpretPageContents(inParser, pageObject.GetPtr(), this);
+        }
+        pageArena.EndPage();
     }
 
     // Save font info before resetting interpreter state
     fontInfoMap = textInterpeter.GetFontInfoMap();
 
+    textInterpeter.SetFontDecoderPrefetcher(NULL);
+    textInterpeter.SetMemoryResource(NULL);
     textInterpeter.ResetInterpretationState();
 
     return status;
@@ -83,10 +101,23 @@ EStatusCode TextExtraction::ExtractTextPlacements(PDFParser* inParser, long inSt
 
 static const string scEmpty = "";
 
+void TextExtraction::SetFontPrefetchWorkers(unsigned int inWorkersCount) {
+    fontPrefetchWorkersCount = inWorkersCount;
+}
+
+void TextExtraction::SetCompositionWorkers(unsigned int inWorkersCount) {
+    compositionWorkersCount = inWorkersCount;
+}
+
+const PageArenaStats& TextExtraction::GetPageArenaStats() const {
+    return pageArena.GetStats();
+}
+
 void TextExtraction::ClearState() {
     textsForPages.clear();
     fontInfoMap.clear();
     LatestWarnings.clear();
+    pageArena.ResetStats();
     LatestError.code = eErrorNone;
     LatestError.description = scEmpty;
 }
@@ -115,7 +146,13 @@ EStatusCode TextExtraction::ExtractText(const std::string& inFilePath, long inSt
             break;
         }
 
-        status = ExtractTextPlacements(&parser, inStartPage, inEndPage);
+        if(fontPrefetchWorkersCount > 0) {
+            FontDecoderPrefetcher prefetcher(inFilePath, fontPrefetchWorkersCount);
+            status = ExtractTextPlacements(&parser, inStartPage, inEndPage, &prefetcher);
+        }
+        else {
+            status = ExtractTextPlacements(&parser, inStartPage, inEndPage);
+        }
         if(status != eSuccess)
             break;
 
@@ -162,13 +199,37 @@ FontInfoMap TextExtraction::GetFontInfoMap() const {
 }
 
 void TextExtraction::GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream) {
-    ParsedTextPlacementListList::iterator itPages = textsForPages.begin();
-    TextComposer composer(bidiFlag, spacingFlag);
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
 
-    for(; itPages != textsForPages.end();++itPages) {
-        composer.ComposeText(*itPages, outStream);
-        outStream<<scCRLN;
-    }
+    GetResultsAsText(bidiFlag, spacingFlag, buffer);
+}
+
+typedef vector<const ParsedTextPlacementList*> ParsedTextPlacementListPtrVector;
+typedef vector<unique_ptr<TextComposer> > TextComposerVector;
+
+void TextExtraction::GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer) {
+    ParallelPageComposer pageComposer(compositionWorkersCount);
+
+    // index the pages, for the workers to pick from
+    ParsedTextPlacementListPtrVector pages;
+    ParsedTextPlacementListList::const_iterator itPages = textsForPages.begin();
+    for(; itPages != textsForPages.end();++itPages)
+        pages.push_back(&(*itPages));
+
+    // composers keep line buffers and bidi state, so one per worker
+    TextComposerVector composers;
+    for(unsigned int i=0;i<pageComposer.GetWorkersCount(pages.size());++i)
+        composers.push_back(unique_ptr<TextComposer>(new TextComposer(bidiFlag, spacingFlag)));
+
+    pageComposer.Compose(
+        pages.size(),
+        [&pages, &composers](size_t inPageIndex, size_t inWorkerIndex, OutputBuffer& outPageBuffer) {
+            composers[inWorkerIndex]->ComposeText(*pages[inPageIndex], outPageBuffer);
+            outPageBuffer.Append(scCRLN);
+        },
+        outBuffer
+    );
 }
 
 
@@ -8,6 +8,8 @@
 #include "./lib/graphic-content-parsing/IGraphicContentInterpreterHandler.h"
 #include "./lib/text-parsing/TextInterpreter.h"
 #include "./lib/font-translation/FontDecoder.h"
+#include "./lib/memory/PageArena.h"
+#include "./lib/output/OutputBuffer.h"
 
 #include "ErrorsAndWarnings.h"
 
@@ -22,6 +24,14 @@ typedef std::list<ParsedTextPlacementList> ParsedTextPlacementListList;
 typedef std::list<ExtractionWarning> ExtractionWarningList;
 
 
+/**
+ * Threading contract:
+ * A TextExtraction object is used by one thread at a time. ExtractText fills the object results and keeps the interpretation
+ * state (font decoders, current page box) in it, so two calls on the same object must not overlap.
+ * Separate TextExtraction objects share no mutable state, so any number of them may run concurrently in one process, including on
+ * the same file. Module level data is either immutable constants or lazily built read-only tables (see FontDecoder).
+ * The exception is DecryptPDFForDebugging, which configures the PDFHummus global trace/log settings. Don't run it alongside other extractions.
+ */
 class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterpreterHandler {
 
     public:
@@ -32,6 +42,17 @@ class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterprete
         PDFHummus::EStatusCode ExtractText(PDFParser* inParser, long inStartPage=0, long inEndPage=-1);
         PDFHummus::EStatusCode ExtractText(IByteReaderWithPosition* inStream, long inStartPage=0, long inEndPage=-1);
 
+        // when extracting from a file, build the document fonts ahead of time with this many worker threads.
+        // 0 (the default) parses fonts when first met by the interpreter
+        void SetFontPrefetchWorkers(unsigned int inWorkersCount);
+
+        // compose the text of pages on this many worker threads in GetResultsAsText. the output is the same as when
+        // composing on the calling thread, which is what happens with 0 or 1 (the default)
+        void SetCompositionWorkers(unsigned int inWorkersCount);
+
+        // page interpretation temporaries are allocated from a per page arena. these are its counters for the latest extraction
+        const PageArenaStats& GetPageArenaStats() const;
+
         ExtractionError LatestError;
         ExtractionWarningList LatestWarnings;
 
@@ -46,6 +67,8 @@ class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterprete
         );
 
         void GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, std::ostream& outStream);
+        // write to an output buffer. it is not flushed, so call Flush on it when done
+        void GetResultsAsText(int bidiFlag, TextComposer::ESpacing spacingFlag, OutputBuffer& outBuffer);
 
         // Get font information for all parsed fonts
         FontInfoMap GetFontInfoMap() const;
@@ -60,8 +83,11 @@ class TextExtraction : public ITextInterpreterHandler, IGraphicContentInterprete
 
     private:
         TextInterpeter textInterpeter;
+        unsigned int fontPrefetchWorkersCount;
+        unsigned int compositionWorkersCount;
+        PageArena pageArena;
         double currentPageScopeBox[4];
 
-        PDFHummus::EStatusCode ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage);
+        PDFHummus::EStatusCode ExtractTextPlacements(PDFParser* inParser, long inStartPage, long inEndPage, FontDecoderPrefetcher* inPrefetcher = NULL);
         void ClearState();
 };
\ No newline at end of file
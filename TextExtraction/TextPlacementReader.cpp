@@ -5,10 +5,23 @@
 #include "PDFParser.h"
 #include "IByteReaderWithPosition.h"
 
+#include "lib/hashing/ContentHash.h"
+#include "lib/output/JSONWriter.h"
+#include "lib/output/StringOutputSink.h"
+#include "lib/placement-columns/PlacementColumnsArrowExport.h"
+#include "lib/placement-columns/PlacementColumnsCache.h"
+#include "lib/result-cache/ExtractionResultCache.h"
+
+#include <algorithm>
 #include <cstring>
+#include <cstdint>
+#include <mutex>
 
 using namespace PDFHummus;
 
+// options of placements cache entries in an ExtractionResultCache. the cache file has a format version of its own
+static const std::string scPlacementsCacheOptions = "placements";
+
 /**
  * Simple adapter to read from a memory buffer.
  * Implements IByteReaderWithPosition interface from PDFHummus.
@@ -70,25 +83,68 @@ private:
     size_t position_;
 };
 
+// a file that can't be stat'ed gets a stamp that won't match the stamp of a file that can
+static FileStamp getFileStamp(const std::string& filePath) {
+    FileStamp stamp = {UINT64_MAX, INT64_MIN};
+    GetFileStamp(filePath, stamp);
+    return stamp;
+}
+
 /**
  * Internal implementation details for TextPlacementReader.
  */
 struct TextPlacementReader::Impl {
-    std::vector<TextPlacement> placements;
+    // a view, which keeps its storage (extracted columns, or a mapped cache file) alive. so exported data may keep
+    // the columns alive after the reader is gone
+    PlacementColumns columns;
     FontInfoMap fontInfoMap;
-    size_t pageCount;
+    uint64_t contentHash = 0; // hash of the PDF bytes the placements were extracted from
     std::vector<uint8_t> blobStorage; // Storage for blob data to keep it alive
 
-    Impl() : pageCount(0) {}
+    // a reader extracted from a file hashes it only when the hash is asked for. till then contentFilePath is set, with
+    // the file stamp from before extraction, to make sure the hashed content is the extracted one
+    std::string contentFilePath;
+    FileStamp contentFileStamp = {0, 0};
+    std::mutex contentHashMutex;
 };
 
+/**
+ * Get the placements of a page range, as pages() has it. Placements are ordered by page,
+ * so the range is a single run of placements [firstIndex, endIndex), found with the page offsets.
+ */
+static void getPageRangePlacements(const PlacementColumns& columns, long startPage, long endPage,
+                                   size_t& firstIndex, size_t& endIndex) {
+    if (startPage < 0) {
+        // no filtering
+        firstIndex = 0;
+        endIndex = columns.placementsCount;
+        return;
+    }
+
+    size_t start = static_cast<size_t>(startPage);
+    firstIndex = start < columns.pagesCount ? static_cast<size_t>(columns.pageOffsets[start]) : columns.placementsCount;
+    if (endPage < 0 || static_cast<size_t>(endPage) >= columns.pagesCount) {
+        endIndex = columns.placementsCount;
+    } else {
+        endIndex = static_cast<size_t>(columns.pageOffsets[endPage]);
+    }
+    if (endIndex < firstIndex) {
+        endIndex = firstIndex;
+    }
+}
+
 // ============================================================================
 // TextPlacementReader implementation
 // ============================================================================
 
+TextPlacementReader::TextPlacementReader()
+    : impl_(std::make_unique<Impl>()) {}
+
 TextPlacementReader::TextPlacementReader(const std::string& filePath)
     : impl_(std::make_unique<Impl>()) {
+    impl_->contentFileStamp = getFileStamp(filePath);
     extractFromFile(filePath);
+    impl_->contentFilePath = filePath;
 }
 
 TextPlacementReader::TextPlacementReader(const char* data, size_t length)
@@ -101,11 +157,93 @@ TextPlacementReader::TextPlacementReader(const std::vector<uint8_t>& blob)
     extractFromBuffer(reinterpret_cast<const char*>(blob.data()), blob.size());
 }
 
+TextPlacementReader TextPlacementReader::open_cached(const std::string& cachePath) {
+    TextPlacementReader reader;
+    if (ReadPlacementColumnsCache(cachePath, reader.impl_->columns, reader.impl_->fontInfoMap, reader.impl_->contentHash) != eSuccess) {
+        throw std::runtime_error("Failed to read placements cache: " + cachePath);
+    }
+    return reader;
+}
+
+TextPlacementReader TextPlacementReader::open_cached(const std::string& cachePath, const std::string& filePath) {
+    return openThroughCache(filePath, cachePath, nullptr);
+}
+
+TextPlacementReader TextPlacementReader::open_cached(ExtractionResultCache& cache, const std::string& filePath) {
+    return openThroughCache(filePath, std::string(), &cache);
+}
+
+TextPlacementReader TextPlacementReader::openThroughCache(const std::string& filePath, const std::string& cachePath,
+                                                          ExtractionResultCache* cache) {
+    TextPlacementReader reader;
+    FileStamp fileStamp = getFileStamp(filePath);
+    reader.hashFile(filePath);
+
+    // in a results cache, the cache file is an entry keyed by the content hash
+    std::string entryPath = cachePath;
+    if (cache) {
+        std::string key = ExtractionResultCache::ComputeKey(reader.impl_->contentHash, scPlacementsCacheOptions);
+        entryPath = cache->GetEntryPath(key, ExtractionResultCache::scPlacementsExtension);
+    }
+
+    // only a cache of the same content will do. check the header hash before mapping the whole cache
+    uint64_t cacheContentHash;
+    if (ReadPlacementColumnsCacheContentHash(entryPath, cacheContentHash) == eSuccess &&
+        cacheContentHash == reader.impl_->contentHash &&
+        ReadPlacementColumnsCache(entryPath, reader.impl_->columns, reader.impl_->fontInfoMap, cacheContentHash) == eSuccess &&
+        cacheContentHash == reader.impl_->contentHash) {
+        if (cache) {
+            cache->Touch(entryPath);
+        }
+        return reader;
+    }
+
+    reader.extractFromFile(filePath);
+    if (!(getFileStamp(filePath) == fileStamp)) {
+        if (!cache) {
+            throw std::runtime_error("PDF file changed while being read: " + filePath);
+        }
+        // in a results cache, placements that are not of the hashed content are just not kept, as CachedExtraction
+        // does with results. the hash is of content from before extraction, so leave it to be computed when asked for
+        reader.impl_->contentFilePath = filePath;
+        reader.impl_->contentFileStamp = fileStamp;
+        return reader;
+    }
+
+    // a cache that can't be written only means extracting again next time
+    if (WritePlacementColumnsCache(entryPath, reader.impl_->columns, reader.impl_->fontInfoMap, reader.impl_->contentHash) == eSuccess &&
+        cache) {
+        cache->Evict();
+    }
+    return reader;
+}
+
 TextPlacementReader::~TextPlacementReader() = default;
 
 TextPlacementReader::TextPlacementReader(TextPlacementReader&& other) noexcept = default;
 TextPlacementReader& TextPlacementReader::operator=(TextPlacementReader&& other) noexcept = default;
 
+void TextPlacementReader::hashFile(const std::string& filePath) {
+    if (!ComputeFileContentHash(filePath, impl_->contentHash)) {
+        throw std::runtime_error("Failed to read PDF file: " + filePath);
+    }
+}
+
+void TextPlacementReader::hashContentFile() const {
+    std::lock_guard<std::mutex> lock(impl_->contentHashMutex);
+    if (impl_->contentFilePath.empty()) {
+        return;
+    }
+
+    if (!ComputeFileContentHash(impl_->contentFilePath, impl_->contentHash)) {
+        throw std::runtime_error("Failed to read PDF file: " + impl_->contentFilePath);
+    }
+    if (!(getFileStamp(impl_->contentFilePath) == impl_->contentFileStamp)) {
+        throw std::runtime_error("PDF file changed since its placements were extracted: " + impl_->contentFilePath);
+    }
+    impl_->contentFilePath.clear();
+}
+
 void TextPlacementReader::extractFromFile(const std::string& filePath) {
     TextExtraction extractor;
     EStatusCode status = extractor.ExtractText(filePath);
@@ -122,30 +260,14 @@ void TextPlacementReader::extractFromFile(const std::string& filePath) {
     impl_->fontInfoMap = extractor.GetFontInfoMap();
 
     // Convert results to our format
-    impl_->pageCount = 0;
-    unsigned long pageNum = 0;
-    for (const auto& pageTexts : extractor.textsForPages) {
-        for (const auto& tp : pageTexts) {
-            TextPlacement placement;
-            placement.pageNumber = pageNum;
-            placement.fontID = tp.fontID;
-            // Convert from [x1, y1, x2, y2] to [x, y, width, height]
-            placement.bbox[0] = tp.globalBbox[0];
-            placement.bbox[1] = tp.globalBbox[1];
-            placement.bbox[2] = tp.globalBbox[2] - tp.globalBbox[0];
-            placement.bbox[3] = tp.globalBbox[3] - tp.globalBbox[1];
-            placement.text = tp.text;
-            impl_->placements.push_back(std::move(placement));
-        }
-        ++pageNum;
-    }
-    impl_->pageCount = pageNum;
+    impl_->columns = BuildPlacementColumns(extractor.textsForPages);
 }
 
 void TextPlacementReader::extractFromBuffer(const char* data, size_t length) {
     // Store the data to keep it alive during parsing
     impl_->blobStorage.assign(reinterpret_cast<const uint8_t*>(data),
                               reinterpret_cast<const uint8_t*>(data) + length);
+    impl_->contentHash = ComputeContentHash(impl_->blobStorage.data(), impl_->blobStorage.size());
 
     MemoryByteReader reader(reinterpret_cast<const char*>(impl_->blobStorage.data()),
                             impl_->blobStorage.size());
@@ -165,42 +287,45 @@ void TextPlacementReader::extractFromBuffer(const char* data, size_t length) {
     impl_->fontInfoMap = extractor.GetFontInfoMap();
 
     // Convert results to our format
-    impl_->pageCount = 0;
-    unsigned long pageNum = 0;
-    for (const auto& pageTexts : extractor.textsForPages) {
-        for (const auto& tp : pageTexts) {
-            TextPlacement placement;
-            placement.pageNumber = pageNum;
-            placement.fontID = tp.fontID;
-            // Convert from [x1, y1, x2, y2] to [x, y, width, height]
-            placement.bbox[0] = tp.globalBbox[0];
-            placement.bbox[1] = tp.globalBbox[1];
-            placement.bbox[2] = tp.globalBbox[2] - tp.globalBbox[0];
-            placement.bbox[3] = tp.globalBbox[3] - tp.globalBbox[1];
-            placement.text = tp.text;
-            impl_->placements.push_back(std::move(placement));
-        }
-        ++pageNum;
-    }
-    impl_->pageCount = pageNum;
+    impl_->columns = BuildPlacementColumns(extractor.textsForPages);
 }
 
 size_t TextPlacementReader::pageCount() const {
-    return impl_->pageCount;
+    return impl_->columns.pagesCount;
 }
 
 size_t TextPlacementReader::placementCount() const {
-    return impl_->placements.size();
+    return impl_->columns.placementsCount;
+}
+
+size_t TextPlacementReader::placementsOnPage(size_t pageIndex) const {
+    const PlacementColumns& columns = impl_->columns;
+    if (pageIndex >= columns.pagesCount) {
+        return 0;
+    }
+    return static_cast<size_t>(columns.pageOffsets[pageIndex + 1] - columns.pageOffsets[pageIndex]);
 }
 
 const FontInfoMap& TextPlacementReader::fonts() const {
     return impl_->fontInfoMap;
 }
 
+uint64_t TextPlacementReader::content_hash() const {
+    hashContentFile();
+    return impl_->contentHash;
+}
+
+void TextPlacementReader::write_cache(const std::string& cachePath) const {
+    hashContentFile();
+    if (WritePlacementColumnsCache(cachePath, impl_->columns, impl_->fontInfoMap, impl_->contentHash) != eSuccess) {
+        throw std::runtime_error("Failed to write placements cache: " + cachePath);
+    }
+}
+
 nlohmann::json TextPlacementReader::summary_json() const {
     nlohmann::json summary;
-    summary["page_count"] = impl_->pageCount;
-    summary["placement_count"] = impl_->placements.size();
+    summary["page_count"] = pageCount();
+    summary["placement_count"] = impl_->columns.placementsCount;
 
     nlohmann::json fonts_array = nlohmann::json::array();
     for (const auto& [id, font] : impl_->fontInfoMap) {
@@ -211,16 +336,107 @@ nlohmann::json TextPlacementReader::summary_json() const {
     return summary;
 }
 
+// JSON writing, with the same keys (in the same, sorted, order) as the nlohmann::json conversions in the header
+
+static void writeFontJson(JSONWriter& writer, const FontInfo& font) {
+    writer.StartObject();
+    writer.Key("ascent");
+    writer.Double(font.ascent);
+    writer.Key("descent");
+    writer.Double(font.descent);
+    writer.Key("family_name");
+    writer.String(font.familyName);
+    writer.Key("font_flags");
+    writer.Integer(font.fontFlags);
+    writer.Key("font_id");
+    writer.UnsignedInteger(font.fontID);
+    writer.Key("font_name");
+    writer.String(font.fontName);
+    writer.Key("font_stretch");
+    writer.String(font.fontStretch);
+    writer.Key("font_weight");
+    writer.Integer(font.fontWeight);
+    writer.Key("space_width");
+    writer.Double(font.spaceWidth);
+    writer.EndObject();
+}
+
+static void writePlacementJson(JSONWriter& writer, const TextPlacement& tp) {
+    writer.StartObject();
+    writer.Key("font_id");
+    writer.UnsignedInteger(tp.fontID);
+    writer.Key("height");
+    writer.Double(tp.bbox[3]);
+    writer.Key("page");
+    writer.UnsignedInteger(tp.pageNumber);
+    writer.Key("text");
+    writer.String(tp.text);
+    writer.Key("width");
+    writer.Double(tp.bbox[2]);
+    writer.Key("x");
+    writer.Double(tp.bbox[0]);
+    writer.Key("y");
+    writer.Double(tp.bbox[1]);
+    writer.EndObject();
+}
+
 std::string TextPlacementReader::summary_json_string() const {
-    return summary_json().dump();
+    std::string result;
+    {
+        StringOutputSink sink(result);
+        OutputBuffer buffer(&sink);
+        write_summary_json(buffer);
+    }
+    return result;
 }
 
 std::string TextPlacementReader::placements_json_string() const {
-    nlohmann::json placements = nlohmann::json::array();
-    for (const auto& tp : impl_->placements) {
-        placements.push_back(tp);  // Uses ADL to_json for TextPlacement
+    std::string result;
+    {
+        StringOutputSink sink(result);
+        OutputBuffer buffer(&sink);
+        write_placements_json(buffer);
+    }
+    return result;
+}
+
+void TextPlacementReader::write_summary_json(OutputBuffer& out) const {
+    JSONWriter writer(out);
+    writer.StartObject();
+    writer.Key("fonts");
+    writer.StartArray();
+    for (const auto& [id, font] : impl_->fontInfoMap) {
+        writeFontJson(writer, font);
+    }
+    writer.EndArray();
+    writer.Key("page_count");
+    writer.UnsignedInteger(pageCount());
+    writer.Key("placement_count");
+    writer.UnsignedInteger(placementCount());
+    writer.EndObject();
+}
+
+void TextPlacementReader::write_placements_json(OutputBuffer& out, long startPage, long endPage) const {
+    JSONWriter writer(out);
+    writer.StartArray();
+    for (const auto& tp : pages(startPage, endPage)) {
+        writePlacementJson(writer, tp);
+    }
+    writer.EndArray();
+}
+
+void TextPlacementReader::export_arrow(ArrowSchema* schema, ArrowArray* array, long startPage, long endPage) const {
+    size_t firstIndex, endIndex;
+    getPageRangePlacements(impl_->columns, startPage, endPage, firstIndex, endIndex);
+    ExportPlacementColumnsToArrow(impl_->columns, firstIndex, endIndex, schema, array);
+}
+
+void TextPlacementReader::write_placements_ndjson(OutputBuffer& out, long startPage, long endPage) const {
+    JSONWriter writer(out);
+    for (const auto& tp : pages(startPage, endPage)) {
+        writePlacementJson(writer, tp);
+        writer.EndLine();
     }
-    return placements.dump();
 }
 
 TextPlacementReader::Iterator TextPlacementReader::begin() const {
@@ -228,59 +444,78 @@ TextPlacementReader::Iterator TextPlacementReader::begin() const {
 }
 
 TextPlacementReader::Iterator TextPlacementReader::end() const {
-    return Iterator(this, impl_->placements.size());
+    return Iterator(this, impl_->columns.placementsCount);
 }
 
 TextPlacementReader::PageRange TextPlacementReader::pages(long startPage, long endPage) const {
     return PageRange(this, startPage, endPage);
 }
 
+TextPlacementReader::Scanner TextPlacementReader::scan(unsigned columns, long startPage, long endPage) const {
+    return Scanner(this, columns, startPage, endPage);
+}
+
 // ============================================================================
 // Iterator implementation
 // ============================================================================
 
 TextPlacementReader::Iterator::Iterator()
-    : extractor_(nullptr), index_(0), startPage_(-1), endPage_(-1) {}
+    : extractor_(nullptr), index_(0), startPage_(-1), endPage_(-1), endIndex_(0), current_() {}
 
 TextPlacementReader::Iterator::Iterator(const TextPlacementReader* extractor, size_t index)
-    : extractor_(extractor), index_(index), startPage_(-1), endPage_(-1) {}
+    : extractor_(extractor), index_(index), startPage_(-1), endPage_(-1), endIndex_(0), current_() {
+    loadCurrent();
+}
 
 TextPlacementReader::Iterator::Iterator(const TextPlacementReader* extractor, size_t index,
                                       long startPage, long endPage)
-    : extractor_(extractor), index_(index), startPage_(startPage), endPage_(endPage) {
+    : extractor_(extractor), index_(index), startPage_(startPage), endPage_(endPage), endIndex_(0), current_() {
     advanceToValidPage();
+    loadCurrent();
+}
+
+void TextPlacementReader::Iterator::loadCurrent() {
+    if (!extractor_ || index_ >= extractor_->impl_->columns.placementsCount) return;
+
+    const PlacementColumns& columns = extractor_->impl_->columns;
+    current_.pageNumber = columns.pageNumbers[index_];
+    current_.fontID = static_cast<ObjectIDType>(columns.fontIDs[index_]);
+    current_.bbox[0] = columns.xs[index_];
+    current_.bbox[1] = columns.ys[index_];
+    current_.bbox[2] = columns.widths[index_];
+    current_.bbox[3] = columns.heights[index_];
+    current_.text = columns.GetText(index_);
 }
 
 void TextPlacementReader::Iterator::advanceToValidPage() {
     if (!extractor_ || startPage_ < 0) return;
 
-    while (index_ < extractor_->impl_->placements.size()) {
-        long page = static_cast<long>(extractor_->impl_->placements[index_].pageNumber);
-        if (page >= startPage_ && (endPage_ < 0 || page < endPage_)) {
-            break;
-        }
-        if (endPage_ >= 0 && page >= endPage_) {
-            // Past the range, go to end
-            index_ = extractor_->impl_->placements.size();
-            break;
-        }
-        ++index_;
+    size_t firstIndex;
+    getPageRangePlacements(extractor_->impl_->columns, startPage_, endPage_, firstIndex, endIndex_);
+    if (index_ < firstIndex) {
+        index_ = firstIndex;
+    }
+    if (index_ >= endIndex_) {
+        // Past the range, go to end
+        index_ = extractor_->impl_->columns.placementsCount;
     }
 }
 
 TextPlacementReader::Iterator::reference TextPlacementReader::Iterator::operator*() const {
-    return extractor_->impl_->placements[index_];
+    return current_;
 }
 
 TextPlacementReader::Iterator::pointer TextPlacementReader::Iterator::operator->() const {
-    return &extractor_->impl_->placements[index_];
+    return &current_;
 }
 
 TextPlacementReader::Iterator& TextPlacementReader::Iterator::operator++() {
     ++index_;
-    if (startPage_ >= 0) {
-        advanceToValidPage();
+    if (startPage_ >= 0 && index_ >= endIndex_) {
+        // Past the range, go to end
+        index_ = extractor_->impl_->columns.placementsCount;
     }
+    loadCurrent();
     return *this;
 }
 
@@ -311,5 +546,68 @@ TextPlacementReader::Iterator TextPlacementReader::PageRange::begin() const {
 }
 
 TextPlacementReader::Iterator TextPlacementReader::PageRange::end() const {
-    return Iterator(extractor_, extractor_->impl_->placements.size());
+    return Iterator(extractor_, extractor_->impl_->columns.placementsCount);
+}
+
+// ============================================================================
+// Scanner implementation
+// ============================================================================
+
+TextPlacementReader::Scanner::Scanner(const TextPlacementReader* extractor, unsigned columns,
+                                      long startPage, long endPage)
+    : extractor_(extractor), columns_(columns), index_(0), endIndex_(0) {
+    getPageRangePlacements(extractor_->impl_->columns, startPage, endPage, index_, endIndex_);
+}
+
+size_t TextPlacementReader::Scanner::next_batch(Batch& out, size_t maxRows) {
+    const PlacementColumns& columns = extractor_->impl_->columns;
+    size_t first = index_;
+    size_t rows = std::min(maxRows, endIndex_ - index_);
+    size_t end = first + rows;
+    index_ = end;
+
+    // placements of the batch are consecutive in the columns, so each column is a block copy
+    if (columns_ & ScanPage) {
+        out.pages.assign(columns.pageNumbers + first, columns.pageNumbers + end);
+    } else {
+        out.pages.clear();
+    }
+
+    if (columns_ & ScanFontID) {
+        out.fontIDs.assign(columns.fontIDs + first, columns.fontIDs + end);
+    } else {
+        out.fontIDs.clear();
+    }
+
+    if (columns_ & ScanBBox) {
+        out.xs.assign(columns.xs + first, columns.xs + end);
+        out.ys.assign(columns.ys + first, columns.ys + end);
+        out.widths.assign(columns.widths + first, columns.widths + end);
+        out.heights.assign(columns.heights + first, columns.heights + end);
+    } else {
+        out.xs.clear();
+        out.ys.clear();
+        out.widths.clear();
+        out.heights.clear();
+    }
+
+    if (columns_ & ScanText) {
+        // offsets are rebased to the batch text
+        uint64_t textStart = columns.textOffsets[first];
+        out.textOffsets.resize(rows + 1);
+        for (size_t i = 0; i <= rows; ++i) {
+            out.textOffsets[i] = columns.textOffsets[first + i] - textStart;
+        }
+        out.textData.assign(columns.textData + textStart, static_cast<size_t>(columns.textOffsets[end] - textStart));
+    } else {
+        out.textOffsets.clear();
+        out.textData.clear();
+    }
+
+    out.rows = rows;
+    return rows;
+}
+
+size_t TextPlacementReader::Scanner::remaining() const {
+    return endIndex_ - index_;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "lib/font-translation/FontDecoder.h"
+#include "lib/output/OutputBuffer.h"
+#include "lib/placement-columns/ArrowCDataInterface.h"
 #include "ObjectsBasicTypes.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <cstdint>
@@ -12,6 +15,8 @@
 
 #include <nlohmann/json.hpp>
 
+class ExtractionResultCache;
+
 // ADL-based JSON serialization for FontInfo (defined in FontDecoder.h)
 inline void to_json(nlohmann::json& j, const FontInfo& f) {
     j = nlohmann::json{
@@ -31,12 +36,16 @@ inline void to_json(nlohmann::json& j, const FontInfo& f) {
  * TextPlacement represents a single text placement in a PDF document.
  * Each placement contains the text content, its position (bounding box),
  * the page it appears on, and the font used.
+ *
+ * Placements are stored by the reader in columns, and TextPlacement is a view
+ * of one row. The text points into the reader storage, so it is valid for as
+ * long as the reader is.
  */
 struct TextPlacement {
     unsigned long pageNumber;    // 0-indexed page number
     ObjectIDType fontID;         // Font identifier (can be used to look up FontInfo)
     double bbox[4];              // Bounding box as [x, y, width, height] in page coordinates
-    std::string text;            // The text content (UTF-8 encoded)
+    std::string_view text;       // The text content (UTF-8 encoded). Not null terminated
 
     /**
      * Convert to JSON object.
@@ -49,7 +58,7 @@ struct TextPlacement {
             {"y", bbox[1]},
             {"width", bbox[2]},
             {"height", bbox[3]},
-            {"text", text}
+            {"text", std::string(text)}
         };
     }
 };
@@ -82,16 +91,54 @@ inline void to_json(nlohmann::json& j, const TextPlacement& tp) {
  *       std::cout << "Page " << tp.pageNumber << ": " << tp.text << std::endl;
  *   }
  *
+ * Placements are kept as columns (page numbers, font ids, bbox coordinates, and all texts in one
+ * UTF-8 buffer with offsets), so scans that look only at pages or boxes don't touch the texts.
+ *
  *   // Iterate specific page range (pages 5-10)
  *   for (const auto& tp : pdf.pages(5, 10)) {
  *       // ...
  *   }
+ *
+ * Extraction results may be kept in a cache file, and mapped from it later instead of extracting again:
+ *
+ *   TextPlacementReader pdf = TextPlacementReader::open_cached("document.tpc", "document.pdf");
+ *
+ * For bindings, export_arrow hands all placements over at once as Arrow columns, without copying them:
+ *
+ *   ArrowSchema schema;
+ *   ArrowArray array;
+ *   pdf.export_arrow(&schema, &array);
+ *
+ * Or pulls them in batches of columns, with a projection and page range:
+ *
+ *   TextPlacementReader::Batch batch;
+ *   auto scanner = pdf.scan(TextPlacementReader::ScanPage | TextPlacementReader::ScanBBox, 5, 10);
+ *   while (scanner.next_batch(batch, 2048) > 0) {
+ *       // batch.pages, batch.xs ... have batch.rows entries
+ *   }
+ *
+ * Thread safety: all extraction happens in the constructor, each reader with its own parser, so readers may be
+ * constructed concurrently on different threads. A constructed reader is read-only - its const methods and
+ * iterators may be used from any number of threads at once. Moving a reader while others read it is a data race.
  */
 class TextPlacementReader {
 public:
     // Forward declarations
     class Iterator;
     class PageRange;
+    class Scanner;
+    struct Batch;
+
+    /**
+     * Columns of a batch scan (see scan()), to be or-ed together into a projection.
+     */
+    enum ScanColumns : unsigned {
+        ScanPage = 1,
+        ScanFontID = 2,
+        ScanBBox = 4,
+        ScanText = 8,
+        ScanAllColumns = ScanPage | ScanFontID | ScanBBox | ScanText
+    };
 
     /**
      * Construct from a file path.
@@ -115,6 +162,38 @@ public:
      */
     explicit TextPlacementReader(const std::vector<uint8_t>& blob);
 
+    /**
+     * Open a placements cache file, written by write_cache.
+     * The file is memory mapped, and placements are read from it as they're accessed. Opening goes over the
+     * page and text offsets and the page numbers, to check them. The file may be replaced while opened.
+     * @param cachePath Path to the cache file
+     * @throws std::runtime_error if the file cannot be opened, or is not a valid placements cache
+     */
+    static TextPlacementReader open_cached(const std::string& cachePath);
+
+    /**
+     * Open the placements of a PDF file through a cache file.
+     * If the cache was written for the same PDF content (see content_hash()) it is opened as with open_cached(cachePath).
+     * Otherwise the PDF is extracted and the cache is written for next time. Failing to write it is not an error.
+     * The PDF file is hashed before extracting it, so it is read twice only on a miss.
+     * @param cachePath Path to the cache file
+     * @param filePath Path to the PDF file
+     * @throws std::runtime_error if the PDF file cannot be opened or parsed, or changed while being read
+     */
+    static TextPlacementReader open_cached(const std::string& cachePath, const std::string& filePath);
+
+    /**
+     * Open the placements of a PDF file through a results cache directory (see ExtractionResultCache).
+     * Same as open_cached(cachePath, filePath), with the cache file kept as an entry of the PDF content in the directory.
+     * It is marked as used when opened, and the directory is evicted to its maximum size when it's written.
+     * Placements of a PDF file that changed while being read are returned without writing them to the cache, and the
+     * reader is then as one constructed from the file (see content_hash()).
+     * @param cache Results cache, opened
+     * @param filePath Path to the PDF file
+     * @throws std::runtime_error if the PDF file cannot be opened or parsed
+     */
+    static TextPlacementReader open_cached(ExtractionResultCache& cache, const std::string& filePath);
+
     ~TextPlacementReader();
 
     // Non-copyable but movable
@@ -133,12 +212,34 @@ public:
      */
     size_t placementCount() const;
 
+    /**
+     * Get the number of text placements on a page.
+     * @param pageIndex Page index (0-indexed). Pages out of the document have no placements
+     */
+    size_t placementsOnPage(size_t pageIndex) const;
+
     /**
      * Get font information for all fonts used in the document.
      * @return Map from font ID to FontInfo
      */
     const FontInfoMap& fonts() const;
 
+    /**
+     * Get a hash of the PDF content the placements were extracted from (64 bits XXH64 of the PDF bytes).
+     * Same content has the same hash, whether read from a file or a buffer.
+     * A reader constructed from a file reads the file again to hash it, on the first call (or write_cache).
+     * @throws std::runtime_error if the file cannot be read, or changed since its placements were extracted
+     */
+    uint64_t content_hash() const;
+
+    /**
+     * Write the placements and fonts to a cache file, to be opened with open_cached.
+     * The file is replaced atomically, so concurrent readers see either the old cache or the new one.
+     * @param cachePath Path to the cache file
+     * @throws std::runtime_error if the file cannot be written, or the PDF file cannot be hashed (see content_hash())
+     */
+    void write_cache(const std::string& cachePath) const;
+
     /**
      * Get document summary as JSON.
      * Returns an object with page_count, placement_count, and fonts array.
@@ -155,6 +256,33 @@ public:
      */
     std::string placements_json_string() const;
 
+    /**
+     * Write the document summary JSON (as in summary_json_string()) to an output buffer.
+     * JSON is written as it goes, without building a JSON document first. The buffer is not flushed.
+     */
+    void write_summary_json(OutputBuffer& out) const;
+
+    /**
+     * Write placements of a page range (as in pages()) as a JSON array to an output buffer.
+     */
+    void write_placements_json(OutputBuffer& out, long startPage = 0, long endPage = -1) const;
+
+    /**
+     * Write placements of a page range (as in pages()) as NDJSON - one placement JSON object per line.
+     */
+    void write_placements_ndjson(OutputBuffer& out, long startPage = 0, long endPage = -1) const;
+
+    /**
+     * Export placements of a page range (as in pages()) through the Arrow C Data Interface.
+     * The array is a struct array (record batch) with the columns page (uint32), font_id (uint64),
+     * x, y, width, height (float64) and text (large_utf8), none of them nullable.
+     * Export is zero-copy. The array buffers point into the reader storage, which the array keeps alive
+     * till released, so it may outlive the reader.
+     * @param schema Receives the schema. The caller owns it, and should call its release callback
+     * @param array Receives the array. The caller owns it, and should call its release callback
+     */
+    void export_arrow(ArrowSchema* schema, ArrowArray* array, long startPage = 0, long endPage = -1) const;
+
     /**
      * Get an iterator to the beginning of all text placements.
      */
@@ -173,8 +301,20 @@ public:
      */
     PageRange pages(long startPage, long endPage = -1) const;
 
+    /**
+     * Get a scanner that reads placements in batches of columns, for consumers that pull many rows at
+     * a time (such as table functions). Only the projected columns are filled, so for example scans
+     * without ScanText don't touch the texts.
+     * @param columns Columns to fill, or-ed ScanColumns values
+     * @param startPage First page to include (0-indexed)
+     * @param endPage One past the last page to include. Use -1 for end of document.
+     */
+    Scanner scan(unsigned columns = ScanAllColumns, long startPage = 0, long endPage = -1) const;
+
     /**
      * Standard forward iterator over TextPlacement objects.
+     * The placement is a view of the current row, held by the iterator. A reference to it is good
+     * till the iterator moves on, copy the placement to keep it longer.
      */
     class Iterator {
     public:
@@ -200,8 +340,11 @@ public:
         size_t index_;
         long startPage_;
         long endPage_;
+        size_t endIndex_;            // with a page range, index of the first placement past it
+        TextPlacement current_;
 
         void advanceToValidPage();
+        void loadCurrent();
     };
 
     /**
@@ -220,10 +363,66 @@ public:
         long endPage_;
     };
 
+    /**
+     * Placements of a batch scan, as columns. One entry per row in each of the projected columns,
+     * others are left empty. A batch is meant to be reused from one next_batch call to the next,
+     * so that its buffers are allocated once.
+     */
+    struct Batch {
+        size_t rows = 0;
+        std::vector<uint32_t> pages;
+        std::vector<ObjectIDType> fontIDs;
+        std::vector<double> xs;              // bounding boxes, as in TextPlacement::bbox
+        std::vector<double> ys;
+        std::vector<double> widths;
+        std::vector<double> heights;
+        std::vector<uint64_t> textOffsets;   // rows + 1 entries. row i text is [textOffsets[i], textOffsets[i+1]) of textData
+        std::string textData;
+
+        std::string_view text(size_t row) const {
+            return std::string_view(textData.data() + textOffsets[row],
+                                    static_cast<size_t>(textOffsets[row + 1] - textOffsets[row]));
+        }
+    };
+
+    /**
+     * Scan over placements in batches. The page range is resolved once, when scanning begins,
+     * and batches are copied from the reader columns as blocks. A scanner is for one thread, while
+     * several scanners may read the same reader at once. The reader should outlive its scanners.
+     */
+    class Scanner {
+    public:
+        Scanner(const TextPlacementReader* extractor, unsigned columns, long startPage, long endPage);
+
+        /**
+         * Fill a batch with the next placements.
+         * @param out Batch to fill. Its columns are replaced
+         * @param maxRows Maximum number of rows to fill
+         * @return Number of rows filled (also out.rows). 0 when the scan is done
+         */
+        size_t next_batch(Batch& out, size_t maxRows);
+
+        /**
+         * Get the number of placements left to scan.
+         */
+        size_t remaining() const;
+
+    private:
+        const TextPlacementReader* extractor_;
+        unsigned columns_;
+        size_t index_;
+        size_t endIndex_;
+    };
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
 
+    TextPlacementReader();
+
+    static TextPlacementReader openThroughCache(const std::string& filePath, const std::string& cachePath, ExtractionResultCache* cache);
+    void hashFile(const std::string& filePath);
+    void hashContentFile() const;
     void extractFromFile(const std::string& filePath);
     void extractFromBuffer(const char* data, size_t length);
 };
@@ -1,91 +1,168 @@
 #include "BidiConversion.h"
-#include "UnicodeString.h"
 #include "ICUInclude.h"
 
 using namespace std;
 using namespace PDFHummus;
 
+#if (SUPPORT_ICU_BIDI==1)
 
-
-BidiConversion::BidiConversion() {
-
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BIDI_SCAN_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// 16 bytes at a time over ascii text, which is most of what lines are made of
+static size_t SkipASCII(const unsigned char* inText, size_t inStart, size_t inLength) {
+    size_t i = inStart;
+#ifdef BIDI_SCAN_SSE2
+    for(; i + 16 <= inLength; i+=16) {
+        if(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(inText + i))) != 0)
+            break;
+    }
+#endif
+    for(; i < inLength && inText[i] < 0x80; ++i);
+    return i;
 }
 
-BidiConversion::~BidiConversion() {
-    
+// check the utf8 sequence starting at inText for code points that may make a LTR line reorder - right to left
+// letters, arabic numbers, and the RTL and embedding/isolate control marks.
+// ranges are a bit wider than the exact RTL blocks, which is fine, those just go through ICU
+static bool IsRightToLeftCandidate(const unsigned char* inText, size_t inLength) {
+    unsigned char lead = inText[0];
+
+    // U+0580..U+07FF. hebrew, arabic, syriac, thaana, nko
+    if(lead >= 0xD6 && lead <= 0xDF)
+        return true;
+    if(inLength < 2)
+        return false;
+    // U+0800..U+08FF. samaritan, mandaic, arabic extended
+    if(lead == 0xE0)
+        return inText[1] >= 0xA0 && inText[1] <= 0xA3;
+    // U+200F RLM, U+202A..U+202E embeddings and overrides, U+2066..U+2069 isolates
+    if(lead == 0xE2) {
+        if(inLength < 3)
+            return false;
+        if(inText[1] == 0x80)
+            return inText[2] == 0x8F || (inText[2] >= 0xAA && inText[2] <= 0xAE);
+        if(inText[1] == 0x81)
+            return inText[2] >= 0xA6 && inText[2] <= 0xA9;
+        return false;
+    }
+    // U+FB00..U+FEFF. hebrew and arabic presentation forms
+    if(lead == 0xEF)
+        return inText[1] >= 0xAC && inText[1] <= 0xBB;
+    // U+10000..U+10FFF and U+1E000..U+1EFFF, which hold the historic RTL scripts, adlam and arabic math symbols
+    if(lead == 0xF0)
+        return inText[1] == 0x90 || inText[1] == 0x9E;
+    return false;
 }
 
-
-#if (SUPPORT_ICU_BIDI==1)
+static bool HasRightToLeftCandidates(const string& inText) {
+    const unsigned char* text = (const unsigned char*)inText.data();
+    size_t length = inText.size();
+
+    size_t i = SkipASCII(text, 0, length);
+    while(i < length) {
+        if(IsRightToLeftCandidate(text + i, length - i))
+            return true;
+        // continuation bytes never match a candidate lead byte, so no need to skip them precisely
+        i = SkipASCII(text, i + 1, length);
+    }
+    return false;
+}
 
 static const int scDirectionLTR = UBIDI_DEFAULT_LTR;
 static const int scDirectionRTL = UBIDI_DEFAULT_RTL;
 
-EStatusCode BidiConversion::ConvertVisualToLogical(const string& inVisualString, int inDirection, string& result) {
-    result = inVisualString;
-
-    if(inVisualString.size() == 0)
-        return eSuccess; // let's not waste time on those
+static const UChar32 scReplacementCharacter = 0xFFFD;
 
+BidiConversion::BidiConversion() {
+    bidi = NULL;
+}
 
-    // create bidi
-    UBiDi* bidi = ubidi_open();
+BidiConversion::~BidiConversion() {
+    if(bidi)
+        ubidi_close(bidi);
+}
 
-    // mark conversion intent to be visual to logical (as this is what we're looking at here)
-    ubidi_setInverse(bidi, true);
+EStatusCode BidiConversion::ConvertVisualToLogical(const string& inVisualString, int inDirection, string& result) {
+    if(inVisualString.size() == 0) {
+        result.clear();
+        return eSuccess; // let's not waste time on those
+    }
+
+    // a left to right paragraph with no right to left text in it stays just as it is
+    if((inDirection == UBIDI_LTR || inDirection == UBIDI_DEFAULT_LTR) && !HasRightToLeftCandidates(inVisualString)) {
+        result = inVisualString;
+        return eSuccess;
+    }
+
+    if(!bidi) {
+        bidi = ubidi_open();
+        if(!bidi) {
+            result = inVisualString;
+            return eFailure;
+        }
+        // mark conversion intent to be visual to logical (as this is what we're looking at here)
+        ubidi_setInverse(bidi, true);
+    }
 
-    // set paragraph with input from visual string. use the existing method of the pdfwriter UnicodeString to handle the utf8 input string...
-    // it was used to generate it...so naturally it understands how to convert "back".
-    UnicodeString helper;
-    helper.FromUTF8(inVisualString);
     UErrorCode errorCode = U_ZERO_ERROR;
-    unsigned long sourceSize = helper.GetUnicodeList().size();
-    UChar* sourceText = new UChar[sourceSize+1];
-    ULongList::iterator it= helper.GetUnicodeList().begin();
-    unsigned long i=0;
-    for(;it != helper.GetUnicodeList().end();++it, ++i)
-        sourceText[i] = (UChar)*it;
-    sourceText[sourceSize]=0;
-
-    UChar* destText = NULL;
     do {
-        ubidi_setPara(bidi, sourceText, sourceSize,
+        // utf8 to utf16. never more utf16 units than there are utf8 bytes
+        sourceText.resize(inVisualString.size() + 1);
+        int32_t sourceSize = 0;
+        u_strFromUTF8WithSub((UChar*)sourceText.data(), (int32_t)sourceText.size(), &sourceSize,
+                                inVisualString.data(), (int32_t)inVisualString.size(),
+                                scReplacementCharacter, NULL, &errorCode);
+        if(U_FAILURE(errorCode))
+            break;
+
+        ubidi_setPara(bidi, (const UChar*)sourceText.data(), sourceSize,
                         inDirection,
                         NULL, &errorCode);
-        if(errorCode != U_ZERO_ERROR)
+        if(U_FAILURE(errorCode))
             break;
 
-        // setup output buffer. should be same as
-        unsigned long targetSize = ubidi_getProcessedLength(bidi);
-        destText = new UChar[targetSize+1]; // +1 to allow bidi to place a final 0
-
-        ubidi_writeReordered(bidi, destText, targetSize+1, UBIDI_DO_MIRRORING, &errorCode);
-
-        if(errorCode != U_ZERO_ERROR)
+        int32_t targetSize = ubidi_getProcessedLength(bidi);
+        targetText.resize(targetSize + 1); // +1 to allow bidi to place a final 0
+        targetSize = ubidi_writeReordered(bidi, (UChar*)targetText.data(), (int32_t)targetText.size(), UBIDI_DO_MIRRORING, &errorCode);
+        if(U_FAILURE(errorCode))
             break;
 
-        // now back to string (wait i want to see how it works...)
-        ULongList targetList;
-        for(unsigned long j=0;j<targetSize;++j)
-            targetList.push_back((unsigned long)destText[j]);
-        helper = targetList;
-        result = helper.ToUTF8().second;
+        // and back to utf8. at most 3 bytes per utf16 unit
+        result.resize(targetSize * 3 + 1);
+        int32_t resultSize = 0;
+        u_strToUTF8WithSub(&result[0], (int32_t)result.size(), &resultSize,
+                            (const UChar*)targetText.data(), targetSize,
+                            scReplacementCharacter, NULL, &errorCode);
+        if(U_FAILURE(errorCode))
+            break;
+        result.resize(resultSize);
     } while(false);
 
-    delete[] sourceText;
-    if(destText)
-        delete[] destText;
-
-    return errorCode == U_ZERO_ERROR ? eSuccess: eFailure;
+    if(U_FAILURE(errorCode)) {
+        result = inVisualString;
+        return eFailure;
+    }
+    return eSuccess;
 }
 #else // SUPPORT_ICU_BIDI
 
 static const int scDirectionLTR = 0;
 static const int scDirectionRTL = 1;
 
+BidiConversion::BidiConversion() {
+    bidi = NULL;
+}
+
+BidiConversion::~BidiConversion() {
+
+}
+
 EStatusCode BidiConversion::ConvertVisualToLogical(const std::string& inVisualString, int inDirection, string& result) {
     result = inVisualString;
     return eSuccess;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -3,8 +3,17 @@
 #include "EStatusCode.h"
 
 #include <string>
+#include <vector>
 
+struct UBiDi;
 
+/**
+ * Visual to logical conversion of text lines, using ICU bidi (when built with it).
+ * An instance holds on to its bidi object and conversion buffers, so the same instance should be used for all the lines
+ * of a composition. Not thread safe, use one instance per thread.
+ *
+ * LTR lines without any right to left characters are returned as is, without going through ICU.
+ */
 class BidiConversion {
     public:
         BidiConversion();
@@ -15,4 +24,15 @@ class BidiConversion {
         static const int scDirectionLTR;
         static const int scDirectionRTL;
 
-};
\ No newline at end of file
+    private:
+        // owns a bidi object, so no copies
+        BidiConversion(const BidiConversion&);
+        BidiConversion& operator=(const BidiConversion&);
+
+        // opened on first use
+        UBiDi* bidi;
+
+        // utf16 buffers, reused between conversions
+        std::vector<char16_t> sourceText;
+        std::vector<char16_t> targetText;
+};
@@ -8,6 +8,7 @@
         #include <icu.h>
     #elif INCLUDE_UBIDI
         #include "unicode/ubidi.h"
+        #include "unicode/ustring.h"
     #endif
 
 #endif
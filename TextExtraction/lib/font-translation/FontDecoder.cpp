@@ -25,8 +25,17 @@ using namespace PDFHummus;
 #define M_CODE 77UL
 static const string scSpace = "space";
 
-static const Encoding scEncoding;
-static const StandardFontsDimensions scStandardFontsDimensions;
+// shared read-only tables. kept as function statics so they are built on first use, where the compiler guards
+// the initialization against concurrent first calls, and without depending on the order of static initialization
+static const Encoding& GetEncoding() {
+    static const Encoding sEncoding;
+    return sEncoding;
+}
+
+static const StandardFontsDimensions& GetStandardFontsDimensions() {
+    static const StandardFontsDimensions sStandardFontsDimensions;
+    return sStandardFontsDimensions;
+}
 
 static unsigned long beToNum(const ByteList& inBytes) {
     unsigned long result = 0;
@@ -86,14 +95,14 @@ static ULongList besToUnicodes(const ByteList& inBytes) {
 static const ByteToStringMap*  GetStandardEncodingMap(const string& inEncodingName) {
     // MacRomanEncoding, MacExpertEncoding, or WinAnsiEncoding
     if(inEncodingName == "WinAnsiEncoding") {
-        return &(scEncoding.WinAnsiEncoding);
+        return &(GetEncoding().WinAnsiEncoding);
     }
 
     if(inEncodingName == "MacExpertEncoding")
-        return &(scEncoding.MacExpertEncoding);
+        return &(GetEncoding().MacExpertEncoding);
 
     if(inEncodingName == "MacRomanEncoding")
-        return &(scEncoding.MacRomanEncoding);
+        return &(GetEncoding().MacRomanEncoding);
 
     return NULL; 
 }  
@@ -209,14 +218,14 @@ void FontDecoder::SetupDifferencesEncodingMap(PDFParser* inParser, PDFDictionary
             RefCountPtr<PDFObject> flagsObject =  inParser->QueryDictionaryObject(fontDescriptor.GetPtr(), "Flags");
             long long flags = ParsedPrimitiveHelper(flagsObject.GetPtr()).GetAsInteger();
             if(flags & (1<<2)) {
-                fromSimpleEncodingMap = scEncoding.SymbolEncoding;
+                fromSimpleEncodingMap = GetEncoding().SymbolEncoding;
             }
             else {
-                fromSimpleEncodingMap = scEncoding.StandardEncoding;
+                fromSimpleEncodingMap = GetEncoding().StandardEncoding;
             }            
         }
         else {
-            fromSimpleEncodingMap = scEncoding.StandardEncoding;
+            fromSimpleEncodingMap = GetEncoding().StandardEncoding;
         }
     }
 
@@ -338,7 +347,7 @@ void FontDecoder::ParseSimpleFontDimensions(PDFParser* inParser, PDFDictionary*
         // wtf. probably one of the standard fonts. aha! [will also take care of ascent descent]
         PDFObjectCastPtr<PDFName> baseFontObject = inParser->QueryDictionaryObject(inFont,"BaseFont");
         if(!!baseFontObject) {
-            const FontWidthDescriptor* descriptor = scStandardFontsDimensions.FindStandardFont(baseFontObject->GetValue());
+            const FontWidthDescriptor* descriptor = GetStandardFontsDimensions().FindStandardFont(baseFontObject->GetValue());
             if(descriptor) {
                 ascent = descriptor->ascent;
                 descent = descriptor->descent;
@@ -489,8 +498,8 @@ string FontDecoder::ToSimpleEncoding(const ByteList& inAsBytes) {
     for(; it!= inAsBytes.end();++it) {
         ByteToStringMap::iterator entryIt = fromSimpleEncodingMap.find(*it);
         if(entryIt != fromSimpleEncodingMap.end()) {
-            StringToULongListMap::const_iterator aglIt = scEncoding.AdobeGlyphList.find(entryIt->second);
-            if(aglIt != scEncoding.AdobeGlyphList.end()) {
+            StringToULongListMap::const_iterator aglIt = GetEncoding().AdobeGlyphList.find(entryIt->second);
+            if(aglIt != GetEncoding().AdobeGlyphList.end()) {
                 const ULongList& mapping = aglIt->second;
                 buffer.insert(buffer.end(), mapping.begin(), mapping.end());
             }
@@ -529,8 +538,8 @@ double FontDecoder::GetCodeWidth(unsigned long inCode) {
         return it->second;
 }
 
-DispositionResultList FontDecoder::ComputeDisplacements(const ByteList& inAsBytes) {
-    DispositionResultList result;
+DispositionResultList FontDecoder::ComputeDisplacements(const ByteList& inAsBytes, pmr::memory_resource* inMemoryResource) {
+    DispositionResultList result(inMemoryResource);
     ByteList::const_iterator it = inAsBytes.begin();
 
     if(isSimpleFont) {
@@ -9,6 +9,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <memory_resource>
 
 class PDFParser;
 class PDFDictionary;
@@ -24,7 +25,7 @@ struct DispositionResult {
     unsigned long code;
 };
 
-typedef std::list<DispositionResult> DispositionResultList;
+typedef std::pmr::list<DispositionResult> DispositionResultList;
 
 struct FontDecoderResult {
     std::string asText;
@@ -46,13 +47,17 @@ struct FontInfo {
 
 typedef std::map<ObjectIDType, FontInfo> FontInfoMap;
 
+// A FontDecoder is built with a parser, and does not keep it. Once constructed it only reads its own data, so a decoder
+// may be built on one thread and then used on another (FontDecoderPrefetcher does that), or used by several threads at once.
+// The encoding and standard fonts tables all decoders share are read-only, built once on first use.
 class FontDecoder {
 
 public:
     FontDecoder(PDFParser* inParser, PDFDictionary* inFont, ObjectIDType inFontID = 0);
 
     FontDecoderResult Translate(const ByteList& inAsBytes);
-    DispositionResultList ComputeDisplacements(const ByteList& inAsBytes);
+    // dispositions list is allocated from inMemoryResource. pass the page arena when computing for a page
+    DispositionResultList ComputeDisplacements(const ByteList& inAsBytes, std::pmr::memory_resource* inMemoryResource = std::pmr::get_default_resource());
     FontInfo GetFontInfo() const;
 
     ObjectIDType fontID;
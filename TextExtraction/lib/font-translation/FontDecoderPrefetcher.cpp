@@ -0,0 +1,243 @@
+#include "FontDecoderPrefetcher.h"
+
+#include "../interpreter/PDFRecursiveInterpreter.h"
+
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFObjectCast.h"
+#include "PDFDictionary.h"
+#include "PDFName.h"
+#include "PDFStreamInput.h"
+#include "PDFIndirectObjectReference.h"
+#include "RefCountPtr.h"
+
+using namespace std;
+using namespace PDFHummus;
+
+static const string scFont = "Font";
+static const string scXObject = "XObject";
+static const string scResources = "Resources";
+static const string scSubtype = "Subtype";
+static const string scForm = "Form";
+
+FontDecoderPrefetcher::FontDecoderPrefetcher(const string& inFilePath, unsigned int inWorkersCount):
+    filePath(inFilePath),
+    workersCount(inWorkersCount),
+    startPage(0),
+    endPage(0),
+    nextFontIndex(0),
+    isListingDone(false),
+    isStopping(false) {
+
+}
+
+FontDecoderPrefetcher::~FontDecoderPrefetcher() {
+    Stop();
+}
+
+void FontDecoderPrefetcher::Start(unsigned long inStartPage, unsigned long inEndPage) {
+    if(workersCount == 0)
+        return;
+
+    startPage = inStartPage;
+    endPage = inEndPage;
+
+    // the first worker lists the fonts, the rest start building them as soon as there are any
+    for(unsigned int i=0;i<workersCount;++i)
+        workers.push_back(thread(&FontDecoderPrefetcher::RunWorker, this, i == 0));
+}
+
+void FontDecoderPrefetcher::Stop() {
+    {
+        lock_guard<mutex> lock(fontsMutex);
+        isStopping = true;
+    }
+    fontListed.notify_all();
+
+    ThreadVector::iterator it = workers.begin();
+    for(; it != workers.end(); ++it)
+        it->join();
+    workers.clear();
+
+    fonts.clear();
+    fontsMap.clear();
+}
+
+void FontDecoderPrefetcher::ListFonts(PDFParser* inParser) {
+    ObjectIDTypeSet seenFonts;
+    ObjectIDTypeSet seenForms;
+
+    // list fonts in the order in which pages will meet them, handing them over page by page, so the first page
+    // fonts are the first to be ready. build the page fonts before going on to the next page, so that listing
+    // does not keep this worker from building while the interpreting thread is already on the first pages
+    for(unsigned long i=startPage;i<=endPage && !isStopping;++i) {
+        RefCountPtr<PDFDictionary> pageObject(inParser->ParsePage(i));
+        if(!pageObject)
+            break;
+        ObjectIDTypeVector fontIDs;
+        ListPageFonts(inParser, pageObject.GetPtr(), fontIDs, seenFonts, seenForms);
+        if(fontIDs.size() == 0)
+            continue;
+        AddListedFonts(fontIDs);
+
+        PrefetchedFont* font;
+        while((font = ClaimFont(false)) != NULL)
+            BuildFont(inParser, true, font);
+    }
+}
+
+void FontDecoderPrefetcher::AddListedFonts(const ObjectIDTypeVector& inFontIDs) {
+    {
+        lock_guard<mutex> lock(fontsMutex);
+        ObjectIDTypeVector::const_iterator it = inFontIDs.begin();
+        for(; it != inFontIDs.end(); ++it) {
+            // skip fonts that the interpreting thread already went for
+            pair<ObjectIDTypeToPrefetchedFontMap::iterator, bool> inserted = fontsMap.insert(ObjectIDTypeToPrefetchedFontMap::value_type(*it, NULL));
+            if(!inserted.second)
+                continue;
+            fonts.push_back(PrefetchedFont());
+            fonts.back().fontID = *it;
+            fonts.back().index = fonts.size() - 1;
+            fonts.back().isDone = false;
+            inserted.first->second = &fonts.back();
+        }
+    }
+    fontListed.notify_all();
+}
+
+void FontDecoderPrefetcher::ListPageFonts(
+    PDFParser* inParser,
+    PDFDictionary* inPage,
+    ObjectIDTypeVector& refFontIDs,
+    ObjectIDTypeSet& refSeenFonts,
+    ObjectIDTypeSet& refSeenForms) {
+    PDFObjectCastPtr<PDFDictionary> resourcesDict(FindInheritedResources(inParser, inPage));
+    if(!resourcesDict)
+        return;
+
+    ListResourcesFonts(inParser, resourcesDict.GetPtr(), refFontIDs, refSeenFonts, refSeenForms);
+}
+
+void FontDecoderPrefetcher::ListResourcesFonts(
+    PDFParser* inParser,
+    PDFDictionary* inResources,
+    ObjectIDTypeVector& refFontIDs,
+    ObjectIDTypeSet& refSeenFonts,
+    ObjectIDTypeSet& refSeenForms) {
+
+    PDFObjectCastPtr<PDFDictionary> fontCategoryDict(inParser->QueryDictionaryObject(inResources, scFont));
+    if(!!fontCategoryDict) {
+        MapIterator<PDFNameToPDFObjectMap> it = fontCategoryDict->GetIterator();
+        while(it.MoveNext()) {
+            if(it.GetValue()->GetType() != PDFObject::ePDFObjectIndirectObjectReference)
+                continue;
+            ObjectIDType fontID = ((PDFIndirectObjectReference*)it.GetValue())->mObjectID;
+            if(refSeenFonts.insert(fontID).second)
+                refFontIDs.push_back(fontID);
+        }
+    }
+
+    // recurse into forms, which may have fonts of their own. only read the stream dictionaries, not their content
+    PDFObjectCastPtr<PDFDictionary> xobjectCategoryDict(inParser->QueryDictionaryObject(inResources, scXObject));
+    if(!!xobjectCategoryDict) {
+        MapIterator<PDFNameToPDFObjectMap> it = xobjectCategoryDict->GetIterator();
+        while(it.MoveNext()) {
+            if(it.GetValue()->GetType() != PDFObject::ePDFObjectIndirectObjectReference)
+                continue;
+            ObjectIDType formID = ((PDFIndirectObjectReference*)it.GetValue())->mObjectID;
+            if(!refSeenForms.insert(formID).second)
+                continue;
+
+            PDFObjectCastPtr<PDFStreamInput> xobject(inParser->ParseNewObject(formID));
+            if(!xobject)
+                continue;
+            RefCountPtr<PDFDictionary> xobjectDict(xobject->QueryStreamDictionary());
+            PDFObjectCastPtr<PDFName> subtype(xobjectDict->QueryDirectObject(scSubtype));
+            if(!subtype || subtype->GetValue() != scForm)
+                continue;
+            PDFObjectCastPtr<PDFDictionary> formResourcesDict(inParser->QueryDictionaryObject(xobjectDict.GetPtr(), scResources));
+            if(!formResourcesDict)
+                continue;
+
+            ListResourcesFonts(inParser, formResourcesDict.GetPtr(), refFontIDs, refSeenFonts, refSeenForms);
+        }
+    }
+}
+
+void FontDecoderPrefetcher::RunWorker(bool inShouldList) {
+    InputFile sourceFile;
+    PDFParser parser;
+    bool isParserReady =
+        sourceFile.OpenFile(filePath) == eSuccess &&
+        parser.StartPDFParsing(sourceFile.GetInputStream()) == eSuccess;
+
+    if(inShouldList) {
+        if(isParserReady)
+            ListFonts(&parser);
+        {
+            lock_guard<mutex> lock(fontsMutex);
+            isListingDone = true;
+        }
+        fontListed.notify_all();
+    }
+
+    PrefetchedFont* font;
+    while((font = ClaimFont(true)) != NULL)
+        BuildFont(&parser, isParserReady, font);
+}
+
+FontDecoderPrefetcher::PrefetchedFont* FontDecoderPrefetcher::ClaimFont(bool inShouldWait) {
+    unique_lock<mutex> lock(fontsMutex);
+    for(;;) {
+        if(inShouldWait)
+            fontListed.wait(lock, [this]{return nextFontIndex < fonts.size() || isListingDone || isStopping;});
+        if(nextFontIndex >= fonts.size())
+            return NULL;
+        PrefetchedFont* font = &fonts[nextFontIndex++];
+        // skip fonts that the interpreting thread went for before a worker did. it parses them itself
+        if(!font->isDone)
+            return font;
+    }
+}
+
+void FontDecoderPrefetcher::BuildFont(PDFParser* inParser, bool inIsParserReady, PrefetchedFont* inFont) {
+    FontDecoder* decoder = NULL;
+    // a worker that fails to setup (or is asked to stop) still goes through the listed fonts, marking them
+    // done so that nobody waits on them
+    if(inIsParserReady && !isStopping) {
+        PDFObjectCastPtr<PDFDictionary> fontDict(inParser->ParseNewObject(inFont->fontID));
+        if(!!fontDict)
+            decoder = new FontDecoder(inParser, fontDict.GetPtr(), inFont->fontID);
+    }
+    MarkDone(inFont, decoder);
+}
+
+void FontDecoderPrefetcher::MarkDone(PrefetchedFont* inFont, FontDecoder* inDecoder) {
+    {
+        lock_guard<mutex> lock(fontsMutex);
+        inFont->decoder.reset(inDecoder);
+        inFont->isDone = true;
+    }
+    fontDone.notify_all();
+}
+
+unique_ptr<FontDecoder> FontDecoderPrefetcher::TakeDecoder(ObjectIDType inFontID) {
+    unique_lock<mutex> lock(fontsMutex);
+
+    // a font that is not listed yet is left to the caller, and kept from being listed later
+    pair<ObjectIDTypeToPrefetchedFontMap::iterator, bool> found = fontsMap.insert(ObjectIDTypeToPrefetchedFontMap::value_type(inFontID, NULL));
+    PrefetchedFont* font = found.first->second;
+    if(!font)
+        return unique_ptr<FontDecoder>();
+
+    // so is a font that no worker claimed yet, rather than waiting for the workers to get through the fonts before it.
+    // marking it done has the workers skip it
+    if(font->index >= nextFontIndex) {
+        font->isDone = true;
+        return unique_ptr<FontDecoder>();
+    }
+
+    fontDone.wait(lock, [font]{return font->isDone;});
+    return move(font->decoder);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "FontDecoder.h"
+#include "ObjectsBasicTypes.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class PDFParser;
+class PDFDictionary;
+
+typedef std::vector<ObjectIDType> ObjectIDTypeVector;
+typedef std::set<ObjectIDType> ObjectIDTypeSet;
+
+/**
+ * Builds font decoders ahead of interpretation, on a pool of worker threads.
+ * Start has the workers go through the pages about to be interpreted. The first worker lists the font objects reachable from
+ * the pages resources (including forms that those pages draw), a page at a time, and builds the fonts of each page before
+ * listing the next one, alongside the other workers. Each worker opens its own parser on the source file, so no parsing state
+ * is shared with the interpreting thread, which is free to carry on with the first page right away.
+ * When the interpreting thread meets a font it calls TakeDecoder, which waits for that font decoder if a worker is building it.
+ * A font that no worker got to yet (listed or not) is left for the interpreting thread to parse, and is not prefetched later.
+ *
+ * Only fonts referenced indirectly are prefetched. direct font dictionaries belong to the interpreting parser, and are
+ * left for it to parse.
+ */
+class FontDecoderPrefetcher {
+    public:
+        FontDecoderPrefetcher(const std::string& inFilePath, unsigned int inWorkersCount);
+        ~FontDecoderPrefetcher();
+
+        // start listing the fonts of pages inStartPage..inEndPage (inclusive), and building them.
+        void Start(unsigned long inStartPage, unsigned long inEndPage);
+
+        // stop workers. fonts that were not built yet will not be built, and fonts not taken are dropped.
+        void Stop();
+
+        // get the prefetched decoder for a font object, waiting for it if a worker is building it. returns null if
+        // no worker got to the font yet, or if building it failed. in that case the caller should just parse the font itself.
+        // A font decoder may only be taken once.
+        std::unique_ptr<FontDecoder> TakeDecoder(ObjectIDType inFontID);
+
+    private:
+        struct PrefetchedFont {
+            ObjectIDType fontID;
+            // position in fonts. fonts from nextFontIndex on were not claimed by a worker yet
+            size_t index;
+            std::unique_ptr<FontDecoder> decoder;
+            bool isDone;
+        };
+        // a deque, so fonts stay put while more are listed
+        typedef std::deque<PrefetchedFont> PrefetchedFontDeque;
+        // fonts that TakeDecoder asked for before they were listed map to null
+        typedef std::map<ObjectIDType, PrefetchedFont*> ObjectIDTypeToPrefetchedFontMap;
+        typedef std::vector<std::thread> ThreadVector;
+
+        std::string filePath;
+        unsigned int workersCount;
+        unsigned long startPage;
+        unsigned long endPage;
+
+        // fonts, fontsMap, nextFontIndex and isListingDone are guarded by fontsMutex
+        PrefetchedFontDeque fonts;
+        ObjectIDTypeToPrefetchedFontMap fontsMap;
+        ThreadVector workers;
+
+        size_t nextFontIndex;
+        bool isListingDone;
+        std::atomic<bool> isStopping;
+        std::mutex fontsMutex;
+        std::condition_variable fontListed;
+        std::condition_variable fontDone;
+
+        void ListFonts(PDFParser* inParser);
+        void AddListedFonts(const ObjectIDTypeVector& inFontIDs);
+        void ListPageFonts(PDFParser* inParser, PDFDictionary* inPage, ObjectIDTypeVector& refFontIDs, ObjectIDTypeSet& refSeenFonts, ObjectIDTypeSet& refSeenForms);
+        void ListResourcesFonts(PDFParser* inParser, PDFDictionary* inResources, ObjectIDTypeVector& refFontIDs, ObjectIDTypeSet& refSeenFonts, ObjectIDTypeSet& refSeenForms);
+        void RunWorker(bool inShouldList);
+        PrefetchedFont* ClaimFont(bool inShouldWait);
+        void BuildFont(PDFParser* inParser, bool inIsParserReady, PrefetchedFont* inFont);
+        void MarkDone(PrefetchedFont* inFont, FontDecoder* inDecoder);
+};
@@ -21,6 +21,15 @@ using namespace std;
 
 GraphicContentInterpreter::GraphicContentInterpreter(void) {
     handler = NULL;
+    memoryResource = pmr::get_default_resource();
+    isInTextElement = false;
+}
+
+GraphicContentInterpreter::GraphicContentInterpreter(pmr::memory_resource* inMemoryResource):
+    currentPath(inMemoryResource),
+    currentTextElementCommands(inMemoryResource) {
+    handler = NULL;
+    memoryResource = inMemoryResource;
     isInTextElement = false;
 }
 
@@ -341,8 +350,8 @@ bool GraphicContentInterpreter::EndTextElement() {
     target.fontRef = source.fontRef;
     target.fontSize = source.fontSize;
 
-    // prep result
-    TextElement el = {PlacedTextCommandList(currentTextElementCommands)};
+    // prep result. the commands are moved, not copied, and stay in the interpreter memory resource
+    TextElement el = {std::move(currentTextElementCommands)};
 
     // clear text element state
     currentTextElementCommands.clear();
@@ -421,18 +430,18 @@ bool GraphicContentInterpreter::TStarCommand() {
 }
 
 void GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation) {
-    PlacedTextCommandArgumentVector placements;
+    PlacedTextCommandArgumentVector placements(memoryResource);
     placements.push_back(inTextPlacementOperation);
-    RecordTextPlacement(placements);
+    RecordTextPlacement(std::move(placements));
 }
 
-void GraphicContentInterpreter::RecordTextPlacement(const PlacedTextCommandArgumentVector& inTextPlacementOperations) {
+void GraphicContentInterpreter::RecordTextPlacement(PlacedTextCommandArgumentVector&& inTextPlacementOperations) {
     PlacedTextCommand el = {
-        inTextPlacementOperations,
+        std::move(inTextPlacementOperations),
         ContentGraphicState(CurrentGraphicState()),
         TextGraphicState(CurrentTextState())
     };
-    currentTextElementCommands.push_back(el);
+    currentTextElementCommands.push_back(std::move(el));
 }
 
 bool GraphicContentInterpreter::TjCommand(const PDFObjectVector& inOperands) {
@@ -470,7 +479,7 @@ bool GraphicContentInterpreter::TJCommand(const PDFObjectVector& inOperands) {
     if(inOperands.size() < 1)
         return true; // too few params? ignore
     
-    PlacedTextCommandArgumentVector placements;
+    PlacedTextCommandArgumentVector placements(memoryResource);
     PDFObjectCastPtr<PDFArray> arg;
 
     arg = inOperands.back();
@@ -489,15 +498,14 @@ bool GraphicContentInterpreter::TJCommand(const PDFObjectVector& inOperands) {
         }
     }
 
-    RecordTextPlacement(placements);
+    RecordTextPlacement(std::move(placements));
     return true;
 }
 
 void GraphicContentInterpreter::StartNewSubpathWithPoint(const PathPoint& inPoint) {
-    SubPath newSubPath;
-
-    newSubPath.components.push_back(PathComponent(inPoint));
-    currentPath.subPaths.push_back(newSubPath);
+    // construct in place, so the subpath components use the path memory resource
+    currentPath.subPaths.emplace_back();
+    currentPath.subPaths.back().components.push_back(PathComponent(inPoint));
 }
 
 bool GraphicContentInterpreter::mCommand(const PDFObjectVector& inOperands) {
@@ -626,7 +634,8 @@ bool GraphicContentInterpreter::reCommand(const PDFObjectVector& inOperands) {
     double width = ParsedPrimitiveHelper(inOperands[2]).GetAsDouble();
     double height =  ParsedPrimitiveHelper(inOperands[3]).GetAsDouble();
 
-    SubPath newSubPath;
+    currentPath.subPaths.emplace_back();
+    SubPath& newSubPath = currentPath.subPaths.back();
 
     newSubPath.components.push_back(PathComponent(PathPoint(x,y))); // x y m
     newSubPath.components.push_back(PathComponent(PathPoint(x+width,y))); // (x+width) y l
@@ -636,8 +645,6 @@ bool GraphicContentInterpreter::reCommand(const PDFObjectVector& inOperands) {
     newSubPath.components.push_back(PathComponent(PathPoint(x,y)));
     newSubPath.isClosed = true;
 
-    currentPath.subPaths.push_back(newSubPath);
-
     return true;
 }
 
@@ -646,7 +653,7 @@ bool GraphicContentInterpreter::PaintCurrentPath(bool inShouldStroke, bool inSho
         return true;
 
     PathElement pathElement = {
-        Path(currentPath),
+        std::move(currentPath),
         ContentGraphicState(CurrentGraphicState()),
         inShouldStroke,
         inShouldFill,
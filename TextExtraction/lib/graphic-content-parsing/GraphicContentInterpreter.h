@@ -12,6 +12,7 @@
 
 #include <list>
 #include <map>
+#include <memory_resource>
 
 typedef std::list<TextGraphicState> TextGraphicStateList;
 typedef std::list<ContentGraphicState> GraphicStateList;
@@ -21,6 +22,9 @@ typedef std::list<Resources> ResourcesList;
 class GraphicContentInterpreter: public IPDFRecursiveInterpreterHandler {
 public:
     GraphicContentInterpreter(void);
+    // current path and text element commands are allocated from inMemoryResource, normally a page arena.
+    // if it's released per page, the interpreter has to be destroyed before that
+    GraphicContentInterpreter(std::pmr::memory_resource* inMemoryResource);
     virtual ~GraphicContentInterpreter(void);
 
     // interpret 
@@ -52,6 +56,8 @@ private:
     TextGraphicStateList textGraphicStateStack;
     Path currentPath;
 
+    std::pmr::memory_resource* memoryResource;
+
     bool isInTextElement;
     PlacedTextCommandList currentTextElementCommands;
 
@@ -126,7 +132,7 @@ private:
     bool EndTextElement();
 
     void RecordTextPlacement(const PlacedTextCommandArgument& inTextPlacementOperation);
-    void RecordTextPlacement(const PlacedTextCommandArgumentVector& inTextPlacementOperations);
+    void RecordTextPlacement(PlacedTextCommandArgumentVector&& inTextPlacementOperations);
 
     bool PaintCurrentPath(bool inShouldStroke, bool inShouldFill, EFillMethod inFillMethod);
 };
\ No newline at end of file
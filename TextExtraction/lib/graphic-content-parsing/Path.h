@@ -1,6 +1,8 @@
 #pragma once
 
 #include <list>
+#include <memory_resource>
+#include <utility>
 
 struct PathPoint {
     PathPoint() {
@@ -48,14 +50,26 @@ struct PathComponent {
 };
 
 
-typedef std::list<PathComponent> PathComponentList;
+// path lists take a memory resource, so that page paths can be allocated from the page arena.
+// SubPath and Path are allocator aware, so subpaths placed in a path list allocate their components from the same resource.
+typedef std::pmr::list<PathComponent> PathComponentList;
 
 struct SubPath {
-    SubPath():components() {
+    typedef std::pmr::polymorphic_allocator<SubPath> allocator_type;
+
+    SubPath(const allocator_type& inAllocator = allocator_type()):components(inAllocator) {
         isClosed = false;
     }
 
-    SubPath(const SubPath& inOther):components(inOther.components) {
+    SubPath(const SubPath& inOther, const allocator_type& inAllocator = allocator_type()):components(inOther.components, inAllocator) {
+        isClosed = inOther.isClosed;
+    }
+
+    SubPath(SubPath&& inOther):components(std::move(inOther.components)) {
+        isClosed = inOther.isClosed;
+    }
+
+    SubPath(SubPath&& inOther, const allocator_type& inAllocator):components(std::move(inOther.components), inAllocator) {
         isClosed = inOther.isClosed;
     }
 
@@ -65,7 +79,7 @@ struct SubPath {
 };
 
 
-typedef std::list<SubPath> SubPathList;
+typedef std::pmr::list<SubPath> SubPathList;
 
 /**
  *  A bit about how paths and subpaths and current point n such are expected to work in this representation.
@@ -85,10 +99,15 @@ typedef std::list<SubPath> SubPathList;
  */
 
 struct Path {
-    Path():subPaths() {
+    typedef std::pmr::polymorphic_allocator<SubPath> allocator_type;
+
+    Path(const allocator_type& inAllocator = allocator_type()):subPaths(inAllocator) {
+    }
+
+    Path(const Path& inOther, const allocator_type& inAllocator = allocator_type()):subPaths(inOther.subPaths, inAllocator) {
     }
 
-    Path(const Path& inOther):subPaths(inOther.subPaths) {
+    Path(Path&& inOther):subPaths(std::move(inOther.subPaths)) {
     }
 
     SubPathList subPaths;
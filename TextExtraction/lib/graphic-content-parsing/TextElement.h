@@ -8,6 +8,7 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <memory_resource>
 
 // PlacedTextCommandArgument matches an argument to a text placement command.
 // Mostly it'll be text, but for TJ it might be a text or a position
@@ -32,7 +33,8 @@ struct PlacedTextCommandArgument {
     double pos;
 };
 
-typedef std::vector<PlacedTextCommandArgument> PlacedTextCommandArgumentVector;
+// text element containers allocate from a memory resource, normally the page arena. ByteList is PDFHummus', and stays on the heap
+typedef std::pmr::vector<PlacedTextCommandArgument> PlacedTextCommandArgumentVector;
 
 
 // PlacedTextCommand matches a text placement command like TJ, Tj etc.
@@ -45,7 +47,7 @@ struct PlacedTextCommand {
     TextGraphicState textState;
 };
 
-typedef std::list<PlacedTextCommand> PlacedTextCommandList;
+typedef std::pmr::list<PlacedTextCommand> PlacedTextCommandList;
 
 // TextElement matches a pdf text element, which is what's between an BT...ET sequance.
 struct TextElement {
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Union-find over the items 0..n-1. Used to group lines into tables - every intersection found unites the two lines sets,
+ * and when done, items with the same root are the connected components (transitive intersections, remember split cells).
+ * Union by size with path halving, so for all practical purposes each operation is constant time.
+ */
+class DisjointSets {
+    public:
+        DisjointSets(size_t inItemsCount):parents(inItemsCount), sizes(inItemsCount, 1) {
+            for(size_t i=0;i<inItemsCount;++i)
+                parents[i] = i;
+        }
+
+        size_t Find(size_t inItem) {
+            while(parents[inItem] != inItem) {
+                parents[inItem] = parents[parents[inItem]];
+                inItem = parents[inItem];
+            }
+            return inItem;
+        }
+
+        void Union(size_t inItem1, size_t inItem2) {
+            size_t root1 = Find(inItem1);
+            size_t root2 = Find(inItem2);
+            if(root1 == root2)
+                return;
+
+            // smaller set goes under the bigger one
+            if(sizes[root1] < sizes[root2]) {
+                size_t temp = root1;
+                root1 = root2;
+                root2 = temp;
+            }
+            parents[root2] = root1;
+            sizes[root1] += sizes[root2];
+        }
+
+        size_t GetItemsCount() const {
+            return parents.size();
+        }
+
+    private:
+        std::vector<size_t> parents;
+        std::vector<size_t> sizes;
+};
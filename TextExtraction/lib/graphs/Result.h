@@ -5,11 +5,13 @@ enum EResult {
    EResultErr,
 };
 
+#include <utility>
+
 template<typename T>
 class Result {
     public:
         Result(); // err
-        Result(T inValue); // ok
+        Result(T inValue); // ok. moves the value in, so results of move only types are ok
 
         bool IsOK();
         bool IsErr();
@@ -30,10 +32,9 @@ Result<T>::Result() {
 }
 
 template <typename T>
-Result<T>::Result(T inValue) {
+Result<T>::Result(T inValue):value(std::move(inValue)) {
     // use for good result
     status = EResultOk;
-    value = inValue;
 }
 
 template <typename T>
@@ -0,0 +1,162 @@
+#include "ContentHash.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <vector>
+
+using namespace std;
+
+static const uint64_t scPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t scPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t scPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t scPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t scPrime5 = 0x27D4EB2F165667C5ULL;
+
+static const size_t scStripeSize = 32;
+static const size_t scFileChunkSize = 1024*1024;
+
+static inline uint64_t RotateLeft(uint64_t inValue, int inBits) {
+    return (inValue << inBits) | (inValue >> (64 - inBits));
+}
+
+// XXH64 reads input as little endian
+static inline uint64_t Read64(const unsigned char* inData) {
+    return  (uint64_t)inData[0] | ((uint64_t)inData[1] << 8) | ((uint64_t)inData[2] << 16) | ((uint64_t)inData[3] << 24) |
+            ((uint64_t)inData[4] << 32) | ((uint64_t)inData[5] << 40) | ((uint64_t)inData[6] << 48) | ((uint64_t)inData[7] << 56);
+}
+
+static inline uint32_t Read32(const unsigned char* inData) {
+    return  (uint32_t)inData[0] | ((uint32_t)inData[1] << 8) | ((uint32_t)inData[2] << 16) | ((uint32_t)inData[3] << 24);
+}
+
+static inline uint64_t Round(uint64_t inAccumulator, uint64_t inInput) {
+    inAccumulator += inInput * scPrime2;
+    inAccumulator = RotateLeft(inAccumulator, 31);
+    return inAccumulator * scPrime1;
+}
+
+static inline uint64_t MergeRound(uint64_t inHash, uint64_t inAccumulator) {
+    inHash ^= Round(0, inAccumulator);
+    return inHash * scPrime1 + scPrime4;
+}
+
+static inline void ProcessStripe(uint64_t (&refAccumulators)[4], const unsigned char* inData) {
+    refAccumulators[0] = Round(refAccumulators[0], Read64(inData));
+    refAccumulators[1] = Round(refAccumulators[1], Read64(inData + 8));
+    refAccumulators[2] = Round(refAccumulators[2], Read64(inData + 16));
+    refAccumulators[3] = Round(refAccumulators[3], Read64(inData + 24));
+}
+
+ContentHasher::ContentHasher(uint64_t inSeed) {
+    seed = inSeed;
+    accumulators[0] = inSeed + scPrime1 + scPrime2;
+    accumulators[1] = inSeed + scPrime2;
+    accumulators[2] = inSeed;
+    accumulators[3] = inSeed - scPrime1;
+    totalLength = 0;
+    stripeUsed = 0;
+}
+
+void ContentHasher::Update(const void* inData, size_t inLength) {
+    const unsigned char* data = (const unsigned char*)inData;
+    const unsigned char* end = data + inLength;
+    totalLength += inLength;
+
+    // complete a partial stripe first
+    if(stripeUsed > 0) {
+        size_t count = scStripeSize - stripeUsed < inLength ? scStripeSize - stripeUsed : inLength;
+        memcpy(stripe + stripeUsed, data, count);
+        stripeUsed += count;
+        data += count;
+        if(stripeUsed < scStripeSize)
+            return;
+        ProcessStripe(accumulators, stripe);
+        stripeUsed = 0;
+    }
+
+    for(; (size_t)(end - data) >= scStripeSize; data += scStripeSize)
+        ProcessStripe(accumulators, data);
+
+    memcpy(stripe, data, end - data);
+    stripeUsed = end - data;
+}
+
+uint64_t ContentHasher::Digest() const {
+    uint64_t hash;
+
+    if(totalLength >= scStripeSize) {
+        hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) + RotateLeft(accumulators[2], 12) + RotateLeft(accumulators[3], 18);
+        hash = MergeRound(hash, accumulators[0]);
+        hash = MergeRound(hash, accumulators[1]);
+        hash = MergeRound(hash, accumulators[2]);
+        hash = MergeRound(hash, accumulators[3]);
+    }
+    else {
+        hash = seed + scPrime5;
+    }
+    hash += totalLength;
+
+    // the rest, which didn't make a complete stripe
+    const unsigned char* data = stripe;
+    const unsigned char* end = stripe + stripeUsed;
+    for(; end - data >= 8; data += 8) {
+        hash ^= Round(0, Read64(data));
+        hash = RotateLeft(hash, 27) * scPrime1 + scPrime4;
+    }
+    if(end - data >= 4) {
+        hash ^= (uint64_t)Read32(data) * scPrime1;
+        hash = RotateLeft(hash, 23) * scPrime2 + scPrime3;
+        data += 4;
+    }
+    for(; data < end; ++data) {
+        hash ^= (*data) * scPrime5;
+        hash = RotateLeft(hash, 11) * scPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= scPrime2;
+    hash ^= hash >> 29;
+    hash *= scPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ComputeContentHash(const void* inData, size_t inLength, uint64_t inSeed) {
+    ContentHasher hasher(inSeed);
+    hasher.Update(inData, inLength);
+    return hasher.Digest();
+}
+
+bool ComputeFileContentHash(const std::string& inFilePath, uint64_t& outHash, uint64_t inSeed) {
+    FILE* file = fopen(inFilePath.c_str(), "rb");
+    if(!file)
+        return false;
+
+    ContentHasher hasher(inSeed);
+    vector<unsigned char> chunk(scFileChunkSize);
+    size_t readCount;
+    while((readCount = fread(chunk.data(), 1, chunk.size(), file)) > 0)
+        hasher.Update(chunk.data(), readCount);
+    bool hasFailed = ferror(file) != 0;
+    fclose(file);
+
+    if(hasFailed)
+        return false;
+    outHash = hasher.Digest();
+    return true;
+}
+
+bool GetFileStamp(const std::string& inFilePath, FileStamp& outStamp) {
+    error_code error;
+    uintmax_t size = filesystem::file_size(inFilePath, error);
+    if(error)
+        return false;
+    filesystem::file_time_type modificationTime = filesystem::last_write_time(inFilePath, error);
+    if(error)
+        return false;
+
+    outStamp.size = (uint64_t)size;
+    outStamp.modificationTime = (int64_t)modificationTime.time_since_epoch().count();
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Fast non cryptographic 64 bit hash of content (XXH64), used to key stored extraction results with the content they were
+ * extracted from. Not for security - inputs with the same hash are easy to make on purpose.
+ * ContentHasher hashes content given in pieces, with the same result as hashing it all at once.
+ */
+class ContentHasher {
+    public:
+        ContentHasher(uint64_t inSeed = 0);
+
+        void Update(const void* inData, size_t inLength);
+        uint64_t Digest() const;
+
+    private:
+        uint64_t accumulators[4];
+        uint64_t seed;
+        uint64_t totalLength;
+        // partial stripe, till there's enough data to process it
+        unsigned char stripe[32];
+        size_t stripeUsed;
+};
+
+uint64_t ComputeContentHash(const void* inData, size_t inLength, uint64_t inSeed = 0);
+
+// hash a file content. returns false if the file can't be read
+bool ComputeFileContentHash(const std::string& inFilePath, uint64_t& outHash, uint64_t inSeed = 0);
+
+// size and modification time of a file. hashing a file and reading it again are two reads, and comparing its stamps from before
+// the first to after the second tells if it changed in between
+struct FileStamp {
+    uint64_t size;
+    int64_t modificationTime;
+
+    bool operator==(const FileStamp& inOther) const {
+        return size == inOther.size && modificationTime == inOther.modificationTime;
+    }
+};
+
+// returns false if the file can't be stat'ed
+bool GetFileStamp(const std::string& inFilePath, FileStamp& outStamp);
@@ -31,7 +31,7 @@ static void FreeObjectVector(PDFObjectVector& ioVector) {
     ioVector.clear();  
 }
 
-static PDFObject* FindInheritedResources(PDFParser* inParser,PDFDictionary* inDictionary) {
+PDFObject* FindInheritedResources(PDFParser* inParser,PDFDictionary* inDictionary) {
 	if(inDictionary->Exists("Resources")) {
 		return inParser->QueryDictionaryObject(inDictionary, "Resources");
 	}
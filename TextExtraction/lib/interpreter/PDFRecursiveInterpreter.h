@@ -7,11 +7,16 @@
 typedef std::list<ObjectIDType> ObjectIDTypeList;
 
 class PDFParser;
+class PDFObject;
 class PDFDictionary;
 class PDFStreamInput;
 class PDFObjectParser;
 class InterpreterContext;
 
+// returns the resources dictionary of a page (or form), looking up the pages tree if not defined directly.
+// caller owns the result.
+PDFObject* FindInheritedResources(PDFParser* inParser, PDFDictionary* inDictionary);
+
 class PDFRecursiveInterpreter {
 public:
     PDFRecursiveInterpreter(void);
@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() {
+    data = NULL;
+    size = 0;
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const string& inFilePath) {
+    Close();
+
+    fileHandle = CreateFileA(inFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize)) {
+        Close();
+        return false;
+    }
+    // can't map empty files. they're just no data
+    if(fileSize.QuadPart == 0)
+        return true;
+
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mappingHandle) {
+        Close();
+        return false;
+    }
+    data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!data) {
+        Close();
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::Close() {
+    if(data)
+        UnmapViewOfFile(data);
+    if(mappingHandle)
+        CloseHandle(mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+    data = NULL;
+    size = 0;
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else // _WIN32
+
+bool MappedFile::Open(const string& inFilePath) {
+    Close();
+
+    int fileDescriptor = open(inFilePath.c_str(), O_RDONLY);
+    if(fileDescriptor < 0)
+        return false;
+
+    struct stat fileStatus;
+    if(fstat(fileDescriptor, &fileStatus) != 0) {
+        close(fileDescriptor);
+        return false;
+    }
+    // can't map empty files. they're just no data
+    if(fileStatus.st_size == 0) {
+        close(fileDescriptor);
+        return true;
+    }
+
+    void* mapping = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    // the mapping holds on to the file, no need for the descriptor anymore
+    close(fileDescriptor);
+    if(mapping == MAP_FAILED)
+        return false;
+
+    data = (const char*)mapping;
+    size = (size_t)fileStatus.st_size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if(data)
+        munmap((void*)data, size);
+    data = NULL;
+    size = 0;
+}
+
+#endif // _WIN32
+
+const char* MappedFile::GetData() const {
+    return data;
+}
+
+size_t MappedFile::GetSize() const {
+    return size;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Read only memory mapping of a whole file. Pages are read in by the OS as they're accessed, so opening is O(1) in the file size.
+ * The mapping stays valid till closed, even if the file is replaced meanwhile (files are replaced by renaming over them, see
+ * AtomicFileOutputSink). Not copyable, as it owns the mapping.
+ */
+class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // returns false if the file can't be opened or mapped. an empty file opens with no data
+        bool Open(const std::string& inFilePath);
+        void Close();
+
+        const char* GetData() const;
+        size_t GetSize() const;
+
+    private:
+        const char* data;
+        size_t size;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+};
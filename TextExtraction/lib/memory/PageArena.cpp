@@ -0,0 +1,68 @@
+#include "PageArena.h"
+
+using namespace std;
+
+CountingMemoryResource::CountingMemoryResource(pmr::memory_resource* inUpstream) {
+    upstream = inUpstream;
+    allocationsCount = 0;
+    allocatedBytes = 0;
+}
+
+void CountingMemoryResource::ResetCounters() {
+    allocationsCount = 0;
+    allocatedBytes = 0;
+}
+
+void* CountingMemoryResource::do_allocate(size_t inBytes, size_t inAlignment) {
+    ++allocationsCount;
+    allocatedBytes += inBytes;
+    return upstream->allocate(inBytes, inAlignment);
+}
+
+void CountingMemoryResource::do_deallocate(void* inPointer, size_t inBytes, size_t inAlignment) {
+    upstream->deallocate(inPointer, inBytes, inAlignment);
+}
+
+bool CountingMemoryResource::do_is_equal(const pmr::memory_resource& inOther) const noexcept {
+    return this == &inOther;
+}
+
+PageArena::PageArena(size_t inInitialSize):
+    initialBuffer(new char[inInitialSize]),
+    heapCounter(pmr::new_delete_resource()),
+    arena(initialBuffer.get(), inInitialSize, &heapCounter),
+    arenaCounter(&arena) {
+
+}
+
+PageArena::~PageArena() {
+    arena.release();
+}
+
+pmr::memory_resource* PageArena::GetResource() {
+    return &arenaCounter;
+}
+
+void PageArena::EndPage() {
+    ++stats.pagesCount;
+    stats.arenaAllocationsCount += arenaCounter.allocationsCount;
+    stats.arenaAllocatedBytes += arenaCounter.allocatedBytes;
+    if(arenaCounter.allocatedBytes > stats.maxPageAllocatedBytes)
+        stats.maxPageAllocatedBytes = arenaCounter.allocatedBytes;
+    stats.heapAllocationsCount += heapCounter.allocationsCount;
+    stats.heapAllocatedBytes += heapCounter.allocatedBytes;
+
+    arenaCounter.ResetCounters();
+    heapCounter.ResetCounters();
+
+    // back to the initial buffer. blocks taken from the heap are freed
+    arena.release();
+}
+
+const PageArenaStats& PageArena::GetStats() const {
+    return stats;
+}
+
+void PageArena::ResetStats() {
+    stats = PageArenaStats();
+}
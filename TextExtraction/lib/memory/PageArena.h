@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory_resource>
+#include <memory>
+#include <cstddef>
+
+/**
+ * memory resource that forwards to another resource, counting the allocations going through it.
+ * not thread safe, same as the extraction objects using it.
+ */
+class CountingMemoryResource: public std::pmr::memory_resource {
+    public:
+        CountingMemoryResource(std::pmr::memory_resource* inUpstream = std::pmr::get_default_resource());
+
+        void ResetCounters();
+
+        size_t allocationsCount;
+        size_t allocatedBytes;
+
+    private:
+        std::pmr::memory_resource* upstream;
+
+        virtual void* do_allocate(size_t inBytes, size_t inAlignment);
+        virtual void do_deallocate(void* inPointer, size_t inBytes, size_t inAlignment);
+        virtual bool do_is_equal(const std::pmr::memory_resource& inOther) const noexcept;
+};
+
+struct PageArenaStats {
+    PageArenaStats() {
+        pagesCount = 0;
+        arenaAllocationsCount = 0;
+        arenaAllocatedBytes = 0;
+        maxPageAllocatedBytes = 0;
+        heapAllocationsCount = 0;
+        heapAllocatedBytes = 0;
+    }
+
+    unsigned long pagesCount;
+
+    // allocations served by the arena. each of these would have been a heap allocation without it
+    size_t arenaAllocationsCount;
+    size_t arenaAllocatedBytes;
+    size_t maxPageAllocatedBytes;
+
+    // blocks that the arena itself had to take from the heap, when a page outgrew the arena initial buffer
+    size_t heapAllocationsCount;
+    size_t heapAllocatedBytes;
+};
+
+/**
+ * Monotonic arena for data that lives for the duration of a single page interpretation - text element commands,
+ * paths and glyph dispositions. Allocations are bumps in the arena buffer, and deallocations are no-ops.
+ * EndPage releases everything in one go, and the arena initial buffer is reused by the next page.
+ *
+ * Containers allocating from GetResource() must be gone by the time EndPage is called.
+ */
+class PageArena {
+    public:
+        PageArena(size_t inInitialSize = 64*1024);
+        ~PageArena();
+
+        std::pmr::memory_resource* GetResource();
+
+        // release all page memory, and update stats
+        void EndPage();
+
+        const PageArenaStats& GetStats() const;
+        void ResetStats();
+
+    private:
+        std::unique_ptr<char[]> initialBuffer;
+        CountingMemoryResource heapCounter;
+        std::pmr::monotonic_buffer_resource arena;
+        CountingMemoryResource arenaCounter;
+
+        PageArenaStats stats;
+};
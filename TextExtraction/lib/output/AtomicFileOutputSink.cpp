@@ -0,0 +1,88 @@
+#include "AtomicFileOutputSink.h"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+static const string scTemporaryFileInfix = ".tmp-";
+
+// a name no other writer (in this process or another) will use for its temporary file
+static string GetTemporaryFilePath(const string& inFilePath) {
+    static const unsigned long long scProcessKey = random_device()();
+    static atomic<unsigned long long> sCounter(0);
+
+    unsigned long long key = scProcessKey ^ (unsigned long long)hash<thread::id>()(this_thread::get_id());
+    return inFilePath + scTemporaryFileInfix + to_string(key) + "-" + to_string(sCounter.fetch_add(1));
+}
+
+bool AtomicFileOutputSink::GetTargetFilePath(const string& inTemporaryFilePath, string& outFilePath) {
+    size_t infixPosition = inTemporaryFilePath.rfind(scTemporaryFileInfix);
+    if(infixPosition == string::npos || infixPosition == 0)
+        return false;
+
+    // the infix is followed by the process key and the counter, as GetTemporaryFilePath writes them
+    string suffix = inTemporaryFilePath.substr(infixPosition + scTemporaryFileInfix.size());
+    size_t separatorPosition = suffix.find('-');
+    if( separatorPosition == string::npos || separatorPosition == 0 || separatorPosition == suffix.size() - 1 ||
+        suffix.find_first_not_of("0123456789-") != string::npos || suffix.find('-', separatorPosition + 1) != string::npos)
+        return false;
+
+    outFilePath = inTemporaryFilePath.substr(0, infixPosition);
+    return true;
+}
+
+AtomicFileOutputSink::AtomicFileOutputSink(const string& inFilePath):
+    filePath(inFilePath),
+    temporaryFilePath(GetTemporaryFilePath(inFilePath)),
+    temporaryFile(temporaryFilePath)
+{
+    hasFailed = !temporaryFile.IsOpen();
+    isDone = false;
+}
+
+AtomicFileOutputSink::~AtomicFileOutputSink() {
+    if(!isDone)
+        RemoveTemporaryFile();
+}
+
+bool AtomicFileOutputSink::IsOpen() const {
+    return temporaryFile.IsOpen();
+}
+
+bool AtomicFileOutputSink::Write(const char* inData, size_t inLength) {
+    if(hasFailed || isDone)
+        return false;
+    hasFailed = !temporaryFile.Write(inData, inLength);
+    return !hasFailed;
+}
+
+void AtomicFileOutputSink::RemoveTemporaryFile() {
+    temporaryFile.Close();
+    error_code ignored;
+    filesystem::remove(temporaryFilePath, ignored);
+    isDone = true;
+}
+
+bool AtomicFileOutputSink::Commit() {
+    if(isDone)
+        return false;
+
+    // the data should be on disk before the file is renamed, otherwise a crash may leave a complete looking but empty target
+    bool succeeded = !hasFailed && temporaryFile.Sync();
+    succeeded = temporaryFile.Close() && succeeded;
+    if(succeeded) {
+        error_code renameError;
+        filesystem::rename(temporaryFilePath, filePath, renameError);
+        succeeded = !renameError;
+    }
+
+    if(succeeded)
+        isDone = true;
+    else
+        RemoveTemporaryFile();
+    return succeeded;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "IOutputSink.h"
+#include "FileDescriptorOutputSink.h"
+
+#include <string>
+
+/**
+ * Sink writing a file atomically. Output goes to a temporary file next to the target file, which replaces the target on
+ * Commit. Readers of the target see either the old file or the complete new one, never a partly written file, and concurrent
+ * writers of the same target don't mix their output (the last to commit wins).
+ * Without a successful Commit the temporary file is removed, and the target is left as it was.
+ */
+class AtomicFileOutputSink: public IOutputSink {
+    public:
+        AtomicFileOutputSink(const std::string& inFilePath);
+        virtual ~AtomicFileOutputSink();
+
+        // check for success in creating the temporary file
+        bool IsOpen() const;
+
+        // replace the target file with what was written. flush any OutputBuffer writing here before calling this.
+        // returns false if anything failed along the way, in which case the target is left as it was
+        bool Commit();
+
+        // IOutputSink implementation
+        virtual bool Write(const char* inData, size_t inLength);
+
+        // tell if a file is a temporary file of this sink (by its path), and get the path of the target file it was for
+        static bool GetTargetFilePath(const std::string& inTemporaryFilePath, std::string& outFilePath);
+
+    private:
+        std::string filePath;
+        std::string temporaryFilePath;
+        FileDescriptorOutputSink temporaryFile;
+        bool hasFailed;
+        bool isDone;
+
+        void RemoveTemporaryFile();
+};
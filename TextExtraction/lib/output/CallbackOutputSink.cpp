@@ -0,0 +1,13 @@
+#include "CallbackOutputSink.h"
+
+CallbackOutputSink::CallbackOutputSink(const OutputCallback& inCallback):callback(inCallback) {
+
+}
+
+CallbackOutputSink::~CallbackOutputSink() {
+
+}
+
+bool CallbackOutputSink::Write(const char* inData, size_t inLength) {
+    return callback(inData, inLength);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "IOutputSink.h"
+
+#include <functional>
+
+typedef std::function<bool(const char* inData, size_t inLength)> OutputCallback;
+
+/**
+ * Sink handing output blocks to a user callback. the callback returns false to mark failure.
+ */
+class CallbackOutputSink: public IOutputSink {
+    public:
+        CallbackOutputSink(const OutputCallback& inCallback);
+        virtual ~CallbackOutputSink();
+
+        // IOutputSink implementation
+        virtual bool Write(const char* inData, size_t inLength);
+
+    private:
+        OutputCallback callback;
+};
@@ -0,0 +1,80 @@
+#include "FileDescriptorOutputSink.h"
+
+#include <fcntl.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+FileDescriptorOutputSink::FileDescriptorOutputSink(int inFileDescriptor) {
+    fileDescriptor = inFileDescriptor;
+    ownsFileDescriptor = false;
+}
+
+FileDescriptorOutputSink::FileDescriptorOutputSink(const string& inFilePath) {
+#ifdef _WIN32
+    fileDescriptor = _open(inFilePath.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fileDescriptor = open(inFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    ownsFileDescriptor = true;
+}
+
+FileDescriptorOutputSink::~FileDescriptorOutputSink() {
+    Close();
+}
+
+bool FileDescriptorOutputSink::Sync() {
+    if(fileDescriptor < 0)
+        return false;
+#ifdef _WIN32
+    return _commit(fileDescriptor) == 0;
+#else
+    return fsync(fileDescriptor) == 0;
+#endif
+}
+
+bool FileDescriptorOutputSink::Close() {
+    if(!ownsFileDescriptor || fileDescriptor < 0)
+        return true;
+
+#ifdef _WIN32
+    int result = _close(fileDescriptor);
+#else
+    int result = close(fileDescriptor);
+#endif
+    fileDescriptor = -1;
+    return result == 0;
+}
+
+bool FileDescriptorOutputSink::IsOpen() const {
+    return fileDescriptor >= 0;
+}
+
+bool FileDescriptorOutputSink::Write(const char* inData, size_t inLength) {
+    if(fileDescriptor < 0)
+        return false;
+
+    // write may take less than asked for, so loop till it's all out
+    while(inLength > 0) {
+#ifdef _WIN32
+        unsigned int chunk = inLength > 0x40000000 ? 0x40000000 : (unsigned int)inLength;
+        int written = _write(fileDescriptor, inData, chunk);
+#else
+        ssize_t written = write(fileDescriptor, inData, inLength);
+#endif
+        if(written < 0) {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        inData += written;
+        inLength -= (size_t)written;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "IOutputSink.h"
+
+#include <string>
+
+/**
+ * Sink writing to a file descriptor (e.g. 1 for standard output), or to a file that it opens (and closes).
+ */
+class FileDescriptorOutputSink: public IOutputSink {
+    public:
+        FileDescriptorOutputSink(int inFileDescriptor);
+        // open inFilePath for writing, truncating it. check IsOpen for success
+        FileDescriptorOutputSink(const std::string& inFilePath);
+        virtual ~FileDescriptorOutputSink();
+
+        bool IsOpen() const;
+
+        // have the written data reach the disk (not just the OS cache). returns false on failure
+        bool Sync();
+        // close the file, if this sink opened it. returns false if closing failed (which may mean some data wasn't written)
+        bool Close();
+
+        // IOutputSink implementation
+        virtual bool Write(const char* inData, size_t inLength);
+
+    private:
+        int fileDescriptor;
+        bool ownsFileDescriptor;
+};
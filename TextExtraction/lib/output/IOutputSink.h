@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Destination for composed output. OutputBuffer collects output and hands it to a sink in large blocks.
+ */
+class IOutputSink {
+
+public:
+    virtual ~IOutputSink() {}
+
+    // write all of inLength bytes. return false on failure
+    virtual bool Write(const char* inData, size_t inLength) = 0;
+};
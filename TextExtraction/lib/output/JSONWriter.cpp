@@ -0,0 +1,261 @@
+#include "JSONWriter.h"
+
+#include <charconv>
+#include <cmath>
+
+using namespace std;
+
+static const char scNull[] = "null";
+static const char scTrue[] = "true";
+static const char scFalse[] = "false";
+static const char scReplacementCharacter[] = "\xEF\xBF\xBD"; // U+FFFD
+static const char scHexDigits[] = "0123456789abcdef";
+
+// doubles are written in fixed notation when their decimal point position is in (scMinFixedExponent, scMaxFixedExponent], same as nlohmann::json
+static const int scMinFixedExponent = -4;
+static const int scMaxFixedExponent = 15;
+
+JSONWriter::JSONWriter(OutputBuffer& inBuffer):buffer(inBuffer) {
+    isAfterKey = false;
+}
+
+JSONWriter::~JSONWriter() {
+
+}
+
+void JSONWriter::BeforeValue() {
+    if(isAfterKey) {
+        isAfterKey = false;
+        return;
+    }
+    if(containerHasValues.empty())
+        return;
+    if(containerHasValues.back())
+        buffer.Append(',');
+    else
+        containerHasValues.back() = true;
+}
+
+void JSONWriter::StartObject() {
+    BeforeValue();
+    buffer.Append('{');
+    containerHasValues.push_back(false);
+}
+
+void JSONWriter::EndObject() {
+    buffer.Append('}');
+    containerHasValues.pop_back();
+}
+
+void JSONWriter::StartArray() {
+    BeforeValue();
+    buffer.Append('[');
+    containerHasValues.push_back(false);
+}
+
+void JSONWriter::EndArray() {
+    buffer.Append(']');
+    containerHasValues.pop_back();
+}
+
+void JSONWriter::Key(string_view inKey) {
+    BeforeValue();
+    WriteEscaped(inKey);
+    buffer.Append(':');
+    isAfterKey = true;
+}
+
+void JSONWriter::String(string_view inValue) {
+    BeforeValue();
+    WriteEscaped(inValue);
+}
+
+// length of the valid UTF-8 sequence starting with a non ASCII byte at inText, or 0 if it's not valid
+static size_t GetUTF8SequenceLength(const unsigned char* inText, const unsigned char* inEnd) {
+    size_t length;
+    unsigned char secondLow = 0x80;
+    unsigned char secondHigh = 0xBF;
+
+    if(inText[0] >= 0xC2 && inText[0] <= 0xDF) {
+        length = 2;
+    } else if(inText[0] >= 0xE0 && inText[0] <= 0xEF) {
+        length = 3;
+        // no overlongs, and no surrogates
+        if(inText[0] == 0xE0)
+            secondLow = 0xA0;
+        else if(inText[0] == 0xED)
+            secondHigh = 0x9F;
+    } else if(inText[0] >= 0xF0 && inText[0] <= 0xF4) {
+        length = 4;
+        // no overlongs, and nothing above U+10FFFF
+        if(inText[0] == 0xF0)
+            secondLow = 0x90;
+        else if(inText[0] == 0xF4)
+            secondHigh = 0x8F;
+    } else {
+        return 0;
+    }
+
+    if((size_t)(inEnd - inText) < length)
+        return 0;
+    if(inText[1] < secondLow || inText[1] > secondHigh)
+        return 0;
+    for(size_t i = 2; i < length; ++i) {
+        if(inText[i] < 0x80 || inText[i] > 0xBF)
+            return 0;
+    }
+    return length;
+}
+
+void JSONWriter::WriteEscaped(string_view inText) {
+    const unsigned char* it = (const unsigned char*)inText.data();
+    const unsigned char* end = it + inText.length();
+    const unsigned char* runStart = it;
+
+    buffer.Append('\"');
+    // plain text is copied in runs. only escapes and non ASCII bytes stop a run
+    while(it != end) {
+        unsigned char c = *it;
+        if(c >= 0x20 && c < 0x80 && c != '\"' && c != '\\') {
+            ++it;
+            continue;
+        }
+
+        if(c >= 0x80) {
+            size_t length = GetUTF8SequenceLength(it, end);
+            if(length > 0) {
+                it += length;
+                continue;
+            }
+        }
+
+        buffer.Append((const char*)runStart, it - runStart);
+        switch(c) {
+            case '\"': buffer.Append("\\\"", 2); break;
+            case '\\': buffer.Append("\\\\", 2); break;
+            case '\b': buffer.Append("\\b", 2); break;
+            case '\f': buffer.Append("\\f", 2); break;
+            case '\n': buffer.Append("\\n", 2); break;
+            case '\r': buffer.Append("\\r", 2); break;
+            case '\t': buffer.Append("\\t", 2); break;
+            default:
+                if(c < 0x20) {
+                    char escape[6] = {'\\', 'u', '0', '0', scHexDigits[c >> 4], scHexDigits[c & 0xF]};
+                    buffer.Append(escape, 6);
+                }
+                else {
+                    // byte that doesn't start a valid UTF-8 sequence
+                    buffer.Append(scReplacementCharacter, 3);
+                }
+        }
+        ++it;
+        runStart = it;
+    }
+    buffer.Append((const char*)runStart, it - runStart);
+    buffer.Append('\"');
+}
+
+void JSONWriter::Double(double inValue) {
+    BeforeValue();
+
+    if(!isfinite(inValue)) {
+        buffer.Append(scNull, 4);
+        return;
+    }
+
+    // get the shortest round trip digits and the exponent, in scientific notation, and lay them out like nlohmann::json does
+    char scientific[32];
+    to_chars_result result = to_chars(scientific, scientific + sizeof(scientific), inValue, chars_format::scientific);
+
+    char digits[24];
+    int digitsCount = 0;
+    const char* it = scientific;
+    bool isNegative = *it == '-';
+    if(isNegative)
+        ++it;
+    for(; *it != 'e'; ++it) {
+        if(*it != '.')
+            digits[digitsCount++] = *it;
+    }
+    int exponent = 0;
+    from_chars(*(it + 1) == '+' ? it + 2 : it + 1, result.ptr, exponent);
+    // position of the decimal point relative to the digits start
+    int pointPosition = exponent + 1;
+
+    char formatted[32];
+    int length = 0;
+    if(isNegative)
+        formatted[length++] = '-';
+
+    if(digitsCount <= pointPosition && pointPosition <= scMaxFixedExponent) {
+        // whole number. digits, trailing zeros, and ".0"
+        for(int i = 0; i < digitsCount; ++i)
+            formatted[length++] = digits[i];
+        for(int i = digitsCount; i < pointPosition; ++i)
+            formatted[length++] = '0';
+        formatted[length++] = '.';
+        formatted[length++] = '0';
+    } else if(0 < pointPosition && pointPosition <= scMaxFixedExponent) {
+        for(int i = 0; i < digitsCount; ++i) {
+            if(i == pointPosition)
+                formatted[length++] = '.';
+            formatted[length++] = digits[i];
+        }
+    } else if(scMinFixedExponent < pointPosition && pointPosition <= 0) {
+        formatted[length++] = '0';
+        formatted[length++] = '.';
+        for(int i = pointPosition; i < 0; ++i)
+            formatted[length++] = '0';
+        for(int i = 0; i < digitsCount; ++i)
+            formatted[length++] = digits[i];
+    } else {
+        formatted[length++] = digits[0];
+        if(digitsCount > 1) {
+            formatted[length++] = '.';
+            for(int i = 1; i < digitsCount; ++i)
+                formatted[length++] = digits[i];
+        }
+        // at least two exponent digits
+        formatted[length++] = 'e';
+        formatted[length++] = exponent < 0 ? '-' : '+';
+        int absoluteExponent = exponent < 0 ? -exponent : exponent;
+        if(absoluteExponent < 10)
+            formatted[length++] = '0';
+        length = (int)(to_chars(formatted + length, formatted + sizeof(formatted), absoluteExponent).ptr - formatted);
+    }
+
+    buffer.Append(formatted, length);
+}
+
+void JSONWriter::Integer(long long inValue) {
+    BeforeValue();
+    char formatted[24];
+    to_chars_result result = to_chars(formatted, formatted + sizeof(formatted), inValue);
+    buffer.Append(formatted, result.ptr - formatted);
+}
+
+void JSONWriter::UnsignedInteger(unsigned long long inValue) {
+    BeforeValue();
+    char formatted[24];
+    to_chars_result result = to_chars(formatted, formatted + sizeof(formatted), inValue);
+    buffer.Append(formatted, result.ptr - formatted);
+}
+
+void JSONWriter::Bool(bool inValue) {
+    BeforeValue();
+    if(inValue)
+        buffer.Append(scTrue, 4);
+    else
+        buffer.Append(scFalse, 5);
+}
+
+void JSONWriter::Null() {
+    BeforeValue();
+    buffer.Append(scNull, 4);
+}
+
+void JSONWriter::EndLine() {
+    buffer.Append('\n');
+    containerHasValues.clear();
+    isAfterKey = false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "OutputBuffer.h"
+
+#include <string_view>
+#include <vector>
+
+/**
+ * JSONWriter writes JSON straight to an OutputBuffer, with no document object built on the way.
+ * Values come out the way nlohmann::json dump() writes them - doubles with ".0" for whole numbers and non finite doubles as null,
+ * and strings with the same escaping. Doubles digits are the shortest that read back to the same value, where nlohmann's
+ * may have an extra digit for some values. Invalid UTF-8 in strings is replaced with U+FFFD, rather than failing.
+ * The writer only keeps track of where commas go. It's up to the caller to write keys in objects and a value after each key.
+ */
+class JSONWriter {
+    public:
+        JSONWriter(OutputBuffer& inBuffer);
+        ~JSONWriter();
+
+        void StartObject();
+        void EndObject();
+        void StartArray();
+        void EndArray();
+
+        void Key(std::string_view inKey);
+
+        void String(std::string_view inValue);
+        void Double(double inValue);
+        void Integer(long long inValue);
+        void UnsignedInteger(unsigned long long inValue);
+        void Bool(bool inValue);
+        void Null();
+
+        // end a top level value with a new line, for NDJSON output
+        void EndLine();
+
+    private:
+        OutputBuffer& buffer;
+        // per open object/array, whether it has values already, and so needs a comma before the next one
+        std::vector<bool> containerHasValues;
+        bool isAfterKey;
+
+        void BeforeValue();
+        void WriteEscaped(std::string_view inText);
+};
@@ -0,0 +1,16 @@
+#include "OStreamOutputSink.h"
+
+using namespace std;
+
+OStreamOutputSink::OStreamOutputSink(ostream& inStream):stream(inStream) {
+
+}
+
+OStreamOutputSink::~OStreamOutputSink() {
+
+}
+
+bool OStreamOutputSink::Write(const char* inData, size_t inLength) {
+    stream.write(inData, inLength);
+    return !stream.fail();
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "IOutputSink.h"
+
+#include <ostream>
+
+/**
+ * Sink writing to an std::ostream. Used to keep the ostream based methods, on top of OutputBuffer based composition.
+ */
+class OStreamOutputSink: public IOutputSink {
+    public:
+        OStreamOutputSink(std::ostream& inStream);
+        virtual ~OStreamOutputSink();
+
+        // IOutputSink implementation
+        virtual bool Write(const char* inData, size_t inLength);
+
+        // streams buffer by themselves, so an OutputBuffer in front of one only needs a small buffer. ostream based methods
+        // may be called per cell or per page, where allocating the default buffer would cost more than the composition
+        static const size_t scBufferSize = 4*1024;
+
+    private:
+        std::ostream& stream;
+};
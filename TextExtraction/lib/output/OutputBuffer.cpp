@@ -0,0 +1,65 @@
+#include "OutputBuffer.h"
+
+#include <string.h>
+
+using namespace std;
+using namespace PDFHummus;
+
+OutputBuffer::OutputBuffer(IOutputSink* inSink, size_t inBufferSize):buffer(inBufferSize > 0 ? inBufferSize : 1) {
+    sink = inSink;
+    used = 0;
+    hasFailed = false;
+}
+
+OutputBuffer::~OutputBuffer() {
+    Flush();
+}
+
+void OutputBuffer::Append(const char* inData, size_t inLength) {
+    // empty data may come with no pointer (such as from empty arrays), which memcpy shouldn't get
+    if(inLength == 0)
+        return;
+    if(inLength > buffer.size() - used) {
+        WriteBuffer();
+        // big chunks go straight to the sink, no point in copying them
+        if(inLength >= buffer.size()) {
+            if(!hasFailed)
+                hasFailed = !sink->Write(inData, inLength);
+            return;
+        }
+    }
+    memcpy(buffer.data() + used, inData, inLength);
+    used += inLength;
+}
+
+void OutputBuffer::Append(string_view inText) {
+    Append(inText.data(), inText.length());
+}
+
+void OutputBuffer::Append(char inChar) {
+    if(used == buffer.size())
+        WriteBuffer();
+    buffer[used++] = inChar;
+}
+
+void OutputBuffer::AppendRepeated(char inChar, size_t inCount) {
+    while(inCount > 0) {
+        if(used == buffer.size())
+            WriteBuffer();
+        size_t count = buffer.size() - used < inCount ? buffer.size() - used : inCount;
+        memset(buffer.data() + used, inChar, count);
+        used += count;
+        inCount -= count;
+    }
+}
+
+void OutputBuffer::WriteBuffer() {
+    if(used > 0 && !hasFailed)
+        hasFailed = !sink->Write(buffer.data(), used);
+    used = 0;
+}
+
+EStatusCode OutputBuffer::Flush() {
+    WriteBuffer();
+    return hasFailed ? eFailure : eSuccess;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "EStatusCode.h"
+
+#include "IOutputSink.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * OutputBuffer collects output in one reusable buffer, and writes it to its sink when the buffer fills up, or when flushed.
+ * Failures are sticky. once the sink fails to write the buffer stops writing, and Flush reports the failure.
+ */
+class OutputBuffer {
+    public:
+        OutputBuffer(IOutputSink* inSink, size_t inBufferSize = 256*1024);
+        ~OutputBuffer(); // flushes
+
+        void Append(const char* inData, size_t inLength);
+        void Append(std::string_view inText);
+        void Append(char inChar);
+        void AppendRepeated(char inChar, size_t inCount);
+
+        PDFHummus::EStatusCode Flush();
+
+    private:
+        IOutputSink* sink;
+        std::vector<char> buffer;
+        size_t used;
+        bool hasFailed;
+
+        void WriteBuffer();
+};
@@ -0,0 +1,14 @@
+#include "StringOutputSink.h"
+
+StringOutputSink::StringOutputSink(std::string& refString):target(refString) {
+
+}
+
+StringOutputSink::~StringOutputSink() {
+
+}
+
+bool StringOutputSink::Write(const char* inData, size_t inLength) {
+    target.append(inData, inLength);
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "IOutputSink.h"
+
+#include <string>
+
+/**
+ * Sink appending to an std::string. Used for composing short pieces of text (like table cells) that need another look before being written.
+ * The string is not cleared by the sink, so it can be reused by clearing it between pieces.
+ */
+class StringOutputSink: public IOutputSink {
+    public:
+        StringOutputSink(std::string& refString);
+        virtual ~StringOutputSink();
+
+        // IOutputSink implementation
+        virtual bool Write(const char* inData, size_t inLength);
+
+    private:
+        std::string& target;
+};
@@ -0,0 +1,92 @@
+#include "PlacementColumns.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// offsets of empty columns - a single 0 for the end of nothing
+static const uint64_t scNoOffsets[1] = {0};
+
+PlacementColumns::PlacementColumns() {
+    placementsCount = 0;
+    pagesCount = 0;
+    pageNumbers = NULL;
+    fontIDs = NULL;
+    xs = NULL;
+    ys = NULL;
+    widths = NULL;
+    heights = NULL;
+    textOffsets = scNoOffsets;
+    textData = NULL;
+    pageOffsets = scNoOffsets;
+}
+
+// storage of extracted placements columns
+struct ExtractedColumnsStorage {
+    vector<uint32_t> pageNumbers;
+    vector<uint64_t> fontIDs;
+    vector<double> xs;
+    vector<double> ys;
+    vector<double> widths;
+    vector<double> heights;
+    vector<uint64_t> textOffsets;
+    string textData;
+    vector<uint64_t> pageOffsets;
+};
+
+PlacementColumns BuildPlacementColumns(const ParsedTextPlacementListList& inTextsForPages) {
+    size_t count = 0;
+    size_t textSize = 0;
+    ParsedTextPlacementListList::const_iterator itPages = inTextsForPages.begin();
+    for(; itPages != inTextsForPages.end(); ++itPages) {
+        count += itPages->GetSize();
+        for(size_t i = 0; i < itPages->GetSize(); ++i)
+            textSize += itPages->GetText(i).size();
+    }
+
+    shared_ptr<ExtractedColumnsStorage> storage = make_shared<ExtractedColumnsStorage>();
+    storage->pageNumbers.reserve(count);
+    storage->fontIDs.reserve(count);
+    storage->xs.reserve(count);
+    storage->ys.reserve(count);
+    storage->widths.reserve(count);
+    storage->heights.reserve(count);
+    storage->textOffsets.reserve(count + 1);
+    storage->textData.reserve(textSize);
+    storage->pageOffsets.reserve(inTextsForPages.size() + 1);
+
+    storage->textOffsets.push_back(0);
+    storage->pageOffsets.push_back(0);
+    uint32_t pageIndex = 0;
+    for(itPages = inTextsForPages.begin(); itPages != inTextsForPages.end(); ++itPages, ++pageIndex) {
+        for(size_t i = 0; i < itPages->GetSize(); ++i) {
+            const PackedTextPlacement& placement = itPages->GetPlacement(i);
+            storage->pageNumbers.push_back(pageIndex);
+            storage->fontIDs.push_back(placement.fontID);
+            // from [x1, y1, x2, y2] to [x, y, width, height]
+            storage->xs.push_back(placement.globalBbox[0]);
+            storage->ys.push_back(placement.globalBbox[1]);
+            storage->widths.push_back(placement.globalBbox[2] - placement.globalBbox[0]);
+            storage->heights.push_back(placement.globalBbox[3] - placement.globalBbox[1]);
+            storage->textData.append(itPages->GetText(i));
+            storage->textOffsets.push_back(storage->textData.size());
+        }
+        storage->pageOffsets.push_back(storage->pageNumbers.size());
+    }
+
+    PlacementColumns columns;
+    columns.placementsCount = count;
+    columns.pagesCount = inTextsForPages.size();
+    columns.pageNumbers = storage->pageNumbers.data();
+    columns.fontIDs = storage->fontIDs.data();
+    columns.xs = storage->xs.data();
+    columns.ys = storage->ys.data();
+    columns.widths = storage->widths.data();
+    columns.heights = storage->heights.data();
+    columns.textOffsets = storage->textOffsets.data();
+    columns.textData = storage->textData.data();
+    columns.pageOffsets = storage->pageOffsets.data();
+    columns.storage = storage;
+    return columns;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../text-parsing/ParsedTextPlacement.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <string_view>
+
+/**
+ * Text placements of a document, as columns - one entry per placement in each of the arrays.
+ * Bounding boxes are [x, y, width, height]. Texts are concatenated in textData, placement i text being
+ * [textOffsets[i], textOffsets[i+1]). Placements are ordered by page, page p placements being [pageOffsets[p], pageOffsets[p+1]).
+ *
+ * PlacementColumns is a view. The arrays belong to storage (extracted columns, or a mapped cache file), which the view shares,
+ * so any copy of the view keeps the arrays alive. Arrays are not modified once built, so views may be read from any thread.
+ */
+struct PlacementColumns {
+    PlacementColumns();
+
+    size_t placementsCount;
+    size_t pagesCount;
+
+    const uint32_t* pageNumbers;
+    const uint64_t* fontIDs;
+    const double* xs;
+    const double* ys;
+    const double* widths;
+    const double* heights;
+    const uint64_t* textOffsets; // placementsCount + 1 entries
+    const char* textData;
+    const uint64_t* pageOffsets; // pagesCount + 1 entries
+
+    std::shared_ptr<const void> storage;
+
+    std::string_view GetText(size_t inIndex) const {
+        return std::string_view(textData + textOffsets[inIndex], (size_t)(textOffsets[inIndex + 1] - textOffsets[inIndex]));
+    }
+};
+
+typedef std::list<ParsedTextPlacementList> ParsedTextPlacementListList;
+
+// columns of the pages texts, as extracted by TextExtraction (pages in order, from page 0)
+PlacementColumns BuildPlacementColumns(const ParsedTextPlacementListList& inTextsForPages);
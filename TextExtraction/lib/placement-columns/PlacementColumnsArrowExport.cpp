@@ -0,0 +1,192 @@
+#include "PlacementColumnsArrowExport.h"
+
+#include <memory>
+
+using namespace std;
+
+enum EPlacementColumn {
+    ePlacementColumnPage,
+    ePlacementColumnFontID,
+    ePlacementColumnX,
+    ePlacementColumnY,
+    ePlacementColumnWidth,
+    ePlacementColumnHeight,
+    ePlacementColumnText,
+    ePlacementColumnsCount
+};
+
+static const char* scColumnNames[ePlacementColumnsCount] = {"page", "font_id", "x", "y", "width", "height", "text"};
+static const char* scColumnFormats[ePlacementColumnsCount] = {"I", "L", "g", "g", "g", "g", "U"};
+static const char* scStructFormat = "+s";
+static const char* scStructName = "";
+
+// columns of an empty extraction may have no arrays, while the interface expects buffers. use this one instead
+static const uint64_t scEmptyBuffer[1] = {0};
+
+// schema
+
+struct StructSchemaPrivateData {
+    ArrowSchema children[ePlacementColumnsCount];
+    ArrowSchema* childrenPointers[ePlacementColumnsCount];
+};
+
+// column schemas have only static strings, so there's nothing to free. their memory is the parent's, and a child moved out
+// of the parent is a copy of this struct, so it's fine with the parent gone
+static void ReleaseColumnSchema(ArrowSchema* inSchema) {
+    inSchema->release = NULL;
+}
+
+static void ReleaseStructSchema(ArrowSchema* inSchema) {
+    StructSchemaPrivateData* privateData = (StructSchemaPrivateData*)inSchema->private_data;
+    // moved children have their release callback cleared by the consumer
+    for(int64_t i = 0; i < inSchema->n_children; ++i) {
+        if(inSchema->children[i]->release)
+            inSchema->children[i]->release(inSchema->children[i]);
+    }
+    delete privateData;
+    inSchema->release = NULL;
+}
+
+static void FillSchema(ArrowSchema* outSchema, const char* inFormat, const char* inName) {
+    outSchema->format = inFormat;
+    outSchema->name = inName;
+    outSchema->metadata = NULL;
+    outSchema->flags = 0;
+    outSchema->n_children = 0;
+    outSchema->children = NULL;
+    outSchema->dictionary = NULL;
+    outSchema->release = ReleaseColumnSchema;
+    outSchema->private_data = NULL;
+}
+
+// arrays. each holds a share of the columns storage, so children moved out of the struct array keep their buffers alive
+
+struct ColumnArrayPrivateData {
+    shared_ptr<const void> storage;
+    const void* buffers[3];
+};
+
+struct StructArrayPrivateData {
+    const void* buffers[1];
+    ArrowArray children[ePlacementColumnsCount];
+    ArrowArray* childrenPointers[ePlacementColumnsCount];
+};
+
+static void ReleaseColumnArray(ArrowArray* inArray) {
+    delete (ColumnArrayPrivateData*)inArray->private_data;
+    inArray->release = NULL;
+}
+
+static void ReleaseStructArray(ArrowArray* inArray) {
+    StructArrayPrivateData* privateData = (StructArrayPrivateData*)inArray->private_data;
+    for(int64_t i = 0; i < inArray->n_children; ++i) {
+        if(inArray->children[i]->release)
+            inArray->children[i]->release(inArray->children[i]);
+    }
+    delete privateData;
+    inArray->release = NULL;
+}
+
+static const void* GetBuffer(const void* inBuffer) {
+    return inBuffer ? inBuffer : scEmptyBuffer;
+}
+
+static void FillColumnArray(
+    ArrowArray* outArray,
+    const shared_ptr<const void>& inStorage,
+    size_t inStartIndex,
+    size_t inLength,
+    const void* inValues,
+    const void* inTextData = NULL) {
+    unique_ptr<ColumnArrayPrivateData> privateData(new ColumnArrayPrivateData());
+    privateData->storage = inStorage;
+    // no nulls, so no validity bitmap
+    privateData->buffers[0] = NULL;
+    privateData->buffers[1] = GetBuffer(inValues);
+    privateData->buffers[2] = GetBuffer(inTextData);
+
+    outArray->length = (int64_t)inLength;
+    outArray->null_count = 0;
+    outArray->offset = (int64_t)inStartIndex;
+    outArray->n_buffers = inTextData ? 3 : 2;
+    outArray->n_children = 0;
+    outArray->buffers = privateData->buffers;
+    outArray->children = NULL;
+    outArray->dictionary = NULL;
+    outArray->release = ReleaseColumnArray;
+    outArray->private_data = privateData.release();
+}
+
+void ExportPlacementColumnsToArrow(
+    const PlacementColumns& inColumns,
+    size_t inStartIndex,
+    size_t inEndIndex,
+    ArrowSchema* outSchema,
+    ArrowArray* outArray
+) {
+    if(inEndIndex > inColumns.placementsCount)
+        inEndIndex = inColumns.placementsCount;
+    if(inStartIndex > inEndIndex)
+        inStartIndex = inEndIndex;
+    size_t length = inEndIndex - inStartIndex;
+
+    unique_ptr<StructSchemaPrivateData> schemaPrivateData(new StructSchemaPrivateData());
+    unique_ptr<StructArrayPrivateData> arrayPrivateData(new StructArrayPrivateData());
+
+    const void* columnsValues[ePlacementColumnsCount] = {
+        inColumns.pageNumbers,
+        inColumns.fontIDs,
+        inColumns.xs,
+        inColumns.ys,
+        inColumns.widths,
+        inColumns.heights,
+        // large_utf8 offsets are int64. text offsets are uint64 with the same values, as they're well within int64
+        inColumns.textOffsets
+    };
+
+    for(int i = 0; i < ePlacementColumnsCount; ++i) {
+        FillSchema(schemaPrivateData->children + i, scColumnFormats[i], scColumnNames[i]);
+        schemaPrivateData->childrenPointers[i] = schemaPrivateData->children + i;
+        arrayPrivateData->childrenPointers[i] = arrayPrivateData->children + i;
+    }
+
+    // if an allocation fails, release the children filled till then
+    for(int i = 0; i < ePlacementColumnsCount; ++i)
+        arrayPrivateData->children[i].release = NULL;
+    try {
+        for(int i = 0; i < ePlacementColumnsCount; ++i) {
+            FillColumnArray(
+                arrayPrivateData->children + i,
+                inColumns.storage,
+                inStartIndex,
+                length,
+                columnsValues[i],
+                i == ePlacementColumnText ? GetBuffer(inColumns.textData) : NULL);
+        }
+    } catch(...) {
+        for(int i = 0; i < ePlacementColumnsCount; ++i) {
+            if(arrayPrivateData->children[i].release)
+                arrayPrivateData->children[i].release(arrayPrivateData->children + i);
+        }
+        throw;
+    }
+
+    FillSchema(outSchema, scStructFormat, scStructName);
+    outSchema->n_children = ePlacementColumnsCount;
+    outSchema->children = schemaPrivateData->childrenPointers;
+    outSchema->release = ReleaseStructSchema;
+    outSchema->private_data = schemaPrivateData.release();
+
+    // the struct itself isn't sliced, its children are
+    arrayPrivateData->buffers[0] = NULL;
+    outArray->length = (int64_t)length;
+    outArray->null_count = 0;
+    outArray->offset = 0;
+    outArray->n_buffers = 1;
+    outArray->n_children = ePlacementColumnsCount;
+    outArray->buffers = arrayPrivateData->buffers;
+    outArray->children = arrayPrivateData->childrenPointers;
+    outArray->dictionary = NULL;
+    outArray->release = ReleaseStructArray;
+    outArray->private_data = arrayPrivateData.release();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "PlacementColumns.h"
+#include "ArrowCDataInterface.h"
+
+#include <stddef.h>
+
+/**
+ * Export placement columns through the Arrow C Data Interface, as a struct array (a record batch) with the columns:
+ * page (uint32), font_id (uint64), x, y, width, height (float64) and text (large_utf8). None of them has nulls.
+ *
+ * Export is zero-copy. The Arrow buffers are the columns arrays, and the exported array shares the columns storage,
+ * so it stays valid after the columns (and whoever held them) are gone, till the consumer releases it.
+ * Exported children may be moved out of the array and released separately, as the interface allows.
+ */
+
+// export placements [inStartIndex, inEndIndex). this is done with the arrays offset, so it's zero-copy as well.
+// outSchema and outArray are owned by the consumer from here on, which should call their release callbacks when done
+void ExportPlacementColumnsToArrow(
+    const PlacementColumns& inColumns,
+    size_t inStartIndex,
+    size_t inEndIndex,
+    struct ArrowSchema* outSchema,
+    struct ArrowArray* outArray
+);
@@ -0,0 +1,318 @@
+#include "PlacementColumnsCache.h"
+
+#include "../memory/MappedFile.h"
+#include "../output/AtomicFileOutputSink.h"
+#include "../output/OutputBuffer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const char scMagic[8] = {'T', 'P', 'L', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t scVersion = 1;
+static const uint32_t scByteOrderMark = 0x01020304;
+static const uint64_t scAlignment = 8;
+
+struct PlacementColumnsCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t contentHash;
+    uint64_t placementsCount;
+    uint64_t pagesCount;
+    uint64_t textDataSize;
+    uint64_t fontsCount;
+    uint64_t fontsTableSize;
+    // offsets of the sections from the file start
+    uint64_t pageOffsetsOffset;
+    uint64_t pageNumbersOffset;
+    uint64_t fontIDsOffset;
+    uint64_t xsOffset;
+    uint64_t ysOffset;
+    uint64_t widthsOffset;
+    uint64_t heightsOffset;
+    uint64_t textOffsetsOffset;
+    uint64_t textDataOffset;
+    uint64_t fontsTableOffset;
+    uint64_t fileSize;
+};
+
+static_assert(sizeof(PlacementColumnsCacheHeader) % 8 == 0, "cache header should keep the sections after it aligned");
+
+// fonts table entry. followed by the family name, font name and font stretch texts, and padding to alignment
+struct PlacementColumnsCacheFont {
+    uint64_t fontID;
+    int32_t fontWeight;
+    int32_t fontFlags;
+    double ascent;
+    double descent;
+    double spaceWidth;
+    uint32_t familyNameSize;
+    uint32_t fontNameSize;
+    uint32_t fontStretchSize;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PlacementColumnsCacheFont) % 8 == 0, "cache font entries should keep the ones after them aligned");
+
+static uint64_t Align(uint64_t inOffset) {
+    return (inOffset + scAlignment - 1) / scAlignment * scAlignment;
+}
+
+static void AppendPadding(OutputBuffer& refBuffer, uint64_t inWrittenSize) {
+    refBuffer.AppendRepeated('\0', (size_t)(Align(inWrittenSize) - inWrittenSize));
+}
+
+static uint64_t GetFontEntrySize(const FontInfo& inFont) {
+    return Align(sizeof(PlacementColumnsCacheFont) + inFont.familyName.size() + inFont.fontName.size() + inFont.fontStretch.size());
+}
+
+EStatusCode WritePlacementColumnsCache(
+    const string& inFilePath,
+    const PlacementColumns& inColumns,
+    const FontInfoMap& inFonts,
+    uint64_t inContentHash
+) {
+    uint64_t count = inColumns.placementsCount;
+
+    PlacementColumnsCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, scMagic, sizeof(scMagic));
+    header.version = scVersion;
+    header.byteOrderMark = scByteOrderMark;
+    header.contentHash = inContentHash;
+    header.placementsCount = count;
+    header.pagesCount = inColumns.pagesCount;
+    header.textDataSize = inColumns.textOffsets[count];
+    header.fontsCount = inFonts.size();
+    FontInfoMap::const_iterator itFonts = inFonts.begin();
+    for(; itFonts != inFonts.end(); ++itFonts)
+        header.fontsTableSize += GetFontEntrySize(itFonts->second);
+
+    // lay out the sections, in the order they are written
+    uint64_t offset = sizeof(header);
+    header.pageOffsetsOffset = offset;
+    offset = Align(offset + (header.pagesCount + 1) * sizeof(uint64_t));
+    header.pageNumbersOffset = offset;
+    offset = Align(offset + count * sizeof(uint32_t));
+    header.fontIDsOffset = offset;
+    offset = Align(offset + count * sizeof(uint64_t));
+    header.xsOffset = offset;
+    offset = Align(offset + count * sizeof(double));
+    header.ysOffset = offset;
+    offset = Align(offset + count * sizeof(double));
+    header.widthsOffset = offset;
+    offset = Align(offset + count * sizeof(double));
+    header.heightsOffset = offset;
+    offset = Align(offset + count * sizeof(double));
+    header.textOffsetsOffset = offset;
+    offset = Align(offset + (count + 1) * sizeof(uint64_t));
+    header.textDataOffset = offset;
+    offset = Align(offset + header.textDataSize);
+    header.fontsTableOffset = offset;
+    header.fileSize = offset + header.fontsTableSize;
+
+    AtomicFileOutputSink sink(inFilePath);
+    if(!sink.IsOpen())
+        return eFailure;
+
+    {
+        OutputBuffer buffer(&sink);
+        buffer.Append((const char*)&header, sizeof(header));
+        buffer.Append((const char*)inColumns.pageOffsets, (size_t)((header.pagesCount + 1) * sizeof(uint64_t)));
+        buffer.Append((const char*)inColumns.pageNumbers, (size_t)(count * sizeof(uint32_t)));
+        AppendPadding(buffer, count * sizeof(uint32_t));
+        buffer.Append((const char*)inColumns.fontIDs, (size_t)(count * sizeof(uint64_t)));
+        buffer.Append((const char*)inColumns.xs, (size_t)(count * sizeof(double)));
+        buffer.Append((const char*)inColumns.ys, (size_t)(count * sizeof(double)));
+        buffer.Append((const char*)inColumns.widths, (size_t)(count * sizeof(double)));
+        buffer.Append((const char*)inColumns.heights, (size_t)(count * sizeof(double)));
+        buffer.Append((const char*)inColumns.textOffsets, (size_t)((count + 1) * sizeof(uint64_t)));
+        buffer.Append(inColumns.textData, (size_t)header.textDataSize);
+        AppendPadding(buffer, header.textDataSize);
+
+        for(itFonts = inFonts.begin(); itFonts != inFonts.end(); ++itFonts) {
+            const FontInfo& font = itFonts->second;
+            PlacementColumnsCacheFont entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.fontID = font.fontID;
+            entry.fontWeight = font.fontWeight;
+            entry.fontFlags = font.fontFlags;
+            entry.ascent = font.ascent;
+            entry.descent = font.descent;
+            entry.spaceWidth = font.spaceWidth;
+            entry.familyNameSize = (uint32_t)font.familyName.size();
+            entry.fontNameSize = (uint32_t)font.fontName.size();
+            entry.fontStretchSize = (uint32_t)font.fontStretch.size();
+            buffer.Append((const char*)&entry, sizeof(entry));
+            buffer.Append(font.familyName);
+            buffer.Append(font.fontName);
+            buffer.Append(font.fontStretch);
+            AppendPadding(buffer, font.familyName.size() + font.fontName.size() + font.fontStretch.size());
+        }
+
+        if(buffer.Flush() != eSuccess)
+            return eFailure;
+    }
+
+    return sink.Commit() ? eSuccess : eFailure;
+}
+
+static bool IsValidHeader(const PlacementColumnsCacheHeader& inHeader) {
+    return memcmp(inHeader.magic, scMagic, sizeof(scMagic)) == 0 &&
+            inHeader.version == scVersion &&
+            inHeader.byteOrderMark == scByteOrderMark;
+}
+
+// check that a section is aligned, and within the file. sizes are checked against the file size first, so they don't overflow
+static bool IsValidSection(const PlacementColumnsCacheHeader& inHeader, uint64_t inOffset, uint64_t inCount, uint64_t inItemSize) {
+    if(inOffset % scAlignment != 0 || inOffset > inHeader.fileSize)
+        return false;
+    if(inCount > (inHeader.fileSize - inOffset) / inItemSize)
+        return false;
+    return true;
+}
+
+static bool AreAscendingOffsets(const uint64_t* inOffsets, size_t inCount) {
+    for(size_t i = 1; i < inCount; ++i) {
+        if(inOffsets[i] < inOffsets[i - 1])
+            return false;
+    }
+    return true;
+}
+
+// each placement should be on the page whose range has it
+static bool AreValidPageNumbers(const PlacementColumns& inColumns) {
+    for(size_t page = 0; page < inColumns.pagesCount; ++page) {
+        for(uint64_t i = inColumns.pageOffsets[page]; i < inColumns.pageOffsets[page + 1]; ++i) {
+            if(inColumns.pageNumbers[i] != page)
+                return false;
+        }
+    }
+    return true;
+}
+
+// storage of mapped columns
+struct MappedColumnsStorage {
+    MappedFile file;
+};
+
+template <typename T>
+static const T* GetSection(const char* inData, uint64_t inOffset) {
+    return (const T*)(inData + inOffset);
+}
+
+EStatusCode ReadPlacementColumnsCache(
+    const string& inFilePath,
+    PlacementColumns& outColumns,
+    FontInfoMap& outFonts,
+    uint64_t& outContentHash
+) {
+    shared_ptr<MappedColumnsStorage> storage = make_shared<MappedColumnsStorage>();
+    if(!storage->file.Open(inFilePath))
+        return eFailure;
+
+    const char* data = storage->file.GetData();
+    size_t size = storage->file.GetSize();
+    if(size < sizeof(PlacementColumnsCacheHeader))
+        return eFailure;
+
+    PlacementColumnsCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    if(!IsValidHeader(header) || header.fileSize != size)
+        return eFailure;
+
+    uint64_t count = header.placementsCount;
+    if(count == UINT64_MAX || header.pagesCount == UINT64_MAX)
+        return eFailure;
+    if( !IsValidSection(header, header.pageOffsetsOffset, header.pagesCount + 1, sizeof(uint64_t)) ||
+        !IsValidSection(header, header.pageNumbersOffset, count, sizeof(uint32_t)) ||
+        !IsValidSection(header, header.fontIDsOffset, count, sizeof(uint64_t)) ||
+        !IsValidSection(header, header.xsOffset, count, sizeof(double)) ||
+        !IsValidSection(header, header.ysOffset, count, sizeof(double)) ||
+        !IsValidSection(header, header.widthsOffset, count, sizeof(double)) ||
+        !IsValidSection(header, header.heightsOffset, count, sizeof(double)) ||
+        !IsValidSection(header, header.textOffsetsOffset, count + 1, sizeof(uint64_t)) ||
+        !IsValidSection(header, header.textDataOffset, header.textDataSize, 1) ||
+        !IsValidSection(header, header.fontsTableOffset, header.fontsTableSize, 1))
+        return eFailure;
+
+    PlacementColumns columns;
+    columns.placementsCount = (size_t)count;
+    columns.pagesCount = (size_t)header.pagesCount;
+    columns.pageOffsets = GetSection<uint64_t>(data, header.pageOffsetsOffset);
+    columns.pageNumbers = GetSection<uint32_t>(data, header.pageNumbersOffset);
+    columns.fontIDs = GetSection<uint64_t>(data, header.fontIDsOffset);
+    columns.xs = GetSection<double>(data, header.xsOffset);
+    columns.ys = GetSection<double>(data, header.ysOffset);
+    columns.widths = GetSection<double>(data, header.widthsOffset);
+    columns.heights = GetSection<double>(data, header.heightsOffset);
+    columns.textOffsets = GetSection<uint64_t>(data, header.textOffsetsOffset);
+    columns.textData = GetSection<char>(data, header.textDataOffset);
+
+    // the ends of the offsets should match the other sections
+    if( columns.pageOffsets[0] != 0 || columns.pageOffsets[columns.pagesCount] != count ||
+        columns.textOffsets[0] != 0 || columns.textOffsets[count] != header.textDataSize)
+        return eFailure;
+
+    // and ascend in between, so that a damaged file can't send readers out of the sections
+    if( !AreAscendingOffsets(columns.pageOffsets, columns.pagesCount + 1) ||
+        !AreAscendingOffsets(columns.textOffsets, columns.placementsCount + 1) ||
+        !AreValidPageNumbers(columns))
+        return eFailure;
+
+    FontInfoMap fonts;
+    const char* fontsTable = data + header.fontsTableOffset;
+    uint64_t fontsTableRead = 0;
+    for(uint64_t i = 0; i < header.fontsCount; ++i) {
+        PlacementColumnsCacheFont entry;
+        if(header.fontsTableSize - fontsTableRead < sizeof(entry))
+            return eFailure;
+        memcpy(&entry, fontsTable + fontsTableRead, sizeof(entry));
+        fontsTableRead += sizeof(entry);
+
+        uint64_t textsSize = (uint64_t)entry.familyNameSize + entry.fontNameSize + entry.fontStretchSize;
+        if(header.fontsTableSize - fontsTableRead < textsSize)
+            return eFailure;
+        const char* texts = fontsTable + fontsTableRead;
+
+        FontInfo font;
+        font.fontID = (ObjectIDType)entry.fontID;
+        font.fontWeight = entry.fontWeight;
+        font.fontFlags = entry.fontFlags;
+        font.ascent = entry.ascent;
+        font.descent = entry.descent;
+        font.spaceWidth = entry.spaceWidth;
+        font.familyName.assign(texts, entry.familyNameSize);
+        font.fontName.assign(texts + entry.familyNameSize, entry.fontNameSize);
+        font.fontStretch.assign(texts + entry.familyNameSize + entry.fontNameSize, entry.fontStretchSize);
+        fonts[font.fontID] = font;
+
+        fontsTableRead = Align(fontsTableRead + textsSize);
+        if(fontsTableRead > header.fontsTableSize)
+            return eFailure;
+    }
+
+    columns.storage = storage;
+    outColumns = columns;
+    outFonts.swap(fonts);
+    outContentHash = header.contentHash;
+    return eSuccess;
+}
+
+EStatusCode ReadPlacementColumnsCacheContentHash(const string& inFilePath, uint64_t& outContentHash) {
+    FILE* file = fopen(inFilePath.c_str(), "rb");
+    if(!file)
+        return eFailure;
+
+    PlacementColumnsCacheHeader header;
+    bool hasHeader = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+
+    if(!hasHeader || !IsValidHeader(header))
+        return eFailure;
+    outContentHash = header.contentHash;
+    return eSuccess;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "EStatusCode.h"
+
+#include "PlacementColumns.h"
+#include "../font-translation/FontDecoder.h"
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Binary cache file of placement columns, so extraction results can be used again without extracting them again.
+ * The file has a header, the columns arrays as they are in memory (8 bytes aligned), the text data and a fonts table. Reading it
+ * maps the file and points the columns at it, so the coordinates and texts are not read till they're accessed.
+ * The header holds a hash of the content the placements were extracted from (see ContentHash.h), to tell a stale cache.
+ * Files are in the writing machine byte order, and reading a file of the other byte order fails.
+ * Reading checks the header, that the arrays are within the file, and goes over the page and text offsets and page numbers to check
+ * that they're consistent, so a damaged file fails to read rather than sends readers out of the file. That's linear in the
+ * placements count, reading 20 bytes per placement.
+ */
+
+// write atomically (see AtomicFileOutputSink), so readers never see a partly written cache
+PDFHummus::EStatusCode WritePlacementColumnsCache(
+    const std::string& inFilePath,
+    const PlacementColumns& inColumns,
+    const FontInfoMap& inFonts,
+    uint64_t inContentHash
+);
+
+PDFHummus::EStatusCode ReadPlacementColumnsCache(
+    const std::string& inFilePath,
+    PlacementColumns& outColumns,
+    FontInfoMap& outFonts,
+    uint64_t& outContentHash
+);
+
+// read just the content hash from the cache header, to check if the cache is stale before mapping it
+PDFHummus::EStatusCode ReadPlacementColumnsCacheContentHash(const std::string& inFilePath, uint64_t& outContentHash);
@@ -0,0 +1,268 @@
+#include "CachedExtraction.h"
+
+#include "../../TextExtraction.h"
+#include "../hashing/ContentHash.h"
+#include "../output/StringOutputSink.h"
+
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+// change when the same options give different results, or the parts layout changes, so that older entries aren't used
+static const string scResultsVersion = "2";
+// entry parts: warnings, text, pages tables counts, then the tables
+static const size_t scWarningsPart = 0;
+static const size_t scTextPart = 1;
+static const size_t scPagesTablesCountsPart = 2;
+static const size_t scFirstTablePart = 3;
+// composing tables one at a time, so a small buffer
+static const size_t scTableBufferSize = 4*1024;
+
+void ExtractionResults::WriteAllTablesCSV(OutputBuffer& outBuffer) const {
+    size_t tableIndex = 0;
+    SizeTVector::const_iterator itPages = pagesTablesCounts.begin();
+    for(; itPages != pagesTablesCounts.end(); ++itPages) {
+        for(size_t i = 0; i < *itPages && tableIndex < tables.size(); ++i, ++tableIndex) {
+            outBuffer.Append(tables[tableIndex]);
+            TableExtraction::WriteTableSeparator(outBuffer);
+        }
+        TableExtraction::WritePageSeparator(outBuffer);
+    }
+}
+
+// warnings are kept one per line, code first
+static string EncodeWarnings(const ExtractionWarningList& inWarnings) {
+    ostringstream warnings;
+    ExtractionWarningList::const_iterator it = inWarnings.begin();
+    for(; it != inWarnings.end(); ++it)
+        warnings << (int)it->code << " " << it->description << "\n";
+    return warnings.str();
+}
+
+static bool DecodeWarnings(const string& inWarningsPart, ExtractionWarningList& outWarnings) {
+    istringstream warnings(inWarningsPart);
+    string line;
+    while(getline(warnings, line)) {
+        size_t separator = line.find(' ');
+        if(separator == string::npos || separator == 0)
+            return false;
+        ExtractionWarning warning;
+        warning.code = (EExtractionWarning)atoi(line.substr(0, separator).c_str());
+        warning.description = line.substr(separator + 1);
+        outWarnings.push_back(warning);
+    }
+    return true;
+}
+
+static string EncodePagesTablesCounts(const SizeTVector& inPagesTablesCounts) {
+    ostringstream counts;
+    SizeTVector::const_iterator it = inPagesTablesCounts.begin();
+    for(; it != inPagesTablesCounts.end(); ++it)
+        counts << *it << " ";
+    return counts.str();
+}
+
+// fails if the counts don't add up to the tables count, so a damaged entry is a miss
+static bool DecodePagesTablesCounts(const string& inCountsPart, size_t inTablesCount, SizeTVector& outPagesTablesCounts) {
+    istringstream counts(inCountsPart);
+    size_t count;
+    size_t total = 0;
+    while(counts >> count) {
+        if(count > inTablesCount - total)
+            return false;
+        total += count;
+        outPagesTablesCounts.push_back(count);
+    }
+    return counts.eof() && total == inTablesCount;
+}
+
+static bool DecodeResults(StringVector& inParts, ExtractionResults& outResults) {
+    if(inParts.size() < scFirstTablePart)
+        return false;
+
+    ExtractionResults results;
+    if(!DecodeWarnings(inParts[scWarningsPart], results.warnings))
+        return false;
+    if(!DecodePagesTablesCounts(inParts[scPagesTablesCountsPart], inParts.size() - scFirstTablePart, results.pagesTablesCounts))
+        return false;
+    results.text.swap(inParts[scTextPart]);
+    for(size_t i = scFirstTablePart; i < inParts.size(); ++i) {
+        results.tables.push_back(string());
+        results.tables.back().swap(inParts[i]);
+    }
+
+    outResults = std::move(results);
+    return true;
+}
+
+static void EncodeResults(const ExtractionResults& inResults, StringVector& outParts) {
+    outParts.clear();
+    outParts.reserve(scFirstTablePart + inResults.tables.size());
+    outParts.push_back(EncodeWarnings(inResults.warnings));
+    outParts.push_back(inResults.text);
+    outParts.push_back(EncodePagesTablesCounts(inResults.pagesTablesCounts));
+    outParts.insert(outParts.end(), inResults.tables.begin(), inResults.tables.end());
+}
+
+CachedExtraction::CachedExtraction(ExtractionResultCache* inCache) {
+    cache = inCache;
+    startPage = 0;
+    endPage = -1;
+    bidiFlag = -1;
+    spacing = TextComposer::eSpacingBoth;
+    extractText = true;
+    extractTables = false;
+    tableTextDecoding = TableExtraction::eTextDecodingAllPages;
+    fontPrefetchWorkersCount = 0;
+    compositionWorkersCount = 0;
+    latestCacheUse = eCacheUseNone;
+    LatestError.code = eErrorNone;
+}
+
+CachedExtraction::~CachedExtraction() {
+}
+
+void CachedExtraction::SetPagesRange(long inStartPage, long inEndPage) {
+    startPage = inStartPage;
+    endPage = inEndPage;
+}
+
+void CachedExtraction::SetComposition(int inBidiFlag, TextComposer::ESpacing inSpacing) {
+    bidiFlag = inBidiFlag;
+    spacing = inSpacing;
+}
+
+void CachedExtraction::SetExtraction(bool inExtractText, bool inExtractTables) {
+    extractText = inExtractText;
+    extractTables = inExtractTables;
+}
+
+void CachedExtraction::SetTableTextDecoding(TableExtraction::ETextDecoding inTextDecoding) {
+    tableTextDecoding = inTextDecoding;
+}
+
+void CachedExtraction::SetFontPrefetchWorkers(unsigned int inWorkersCount) {
+    fontPrefetchWorkersCount = inWorkersCount;
+}
+
+void CachedExtraction::SetCompositionWorkers(unsigned int inWorkersCount) {
+    compositionWorkersCount = inWorkersCount;
+}
+
+string CachedExtraction::GetResultsOptions() const {
+    ostringstream options;
+    options << "results " << scResultsVersion
+            << (extractText ? " text" : "")
+            << (extractTables ? " tables" : "")
+            << " start " << startPage
+            << " end " << endPage
+            << " spacing " << spacing
+            << " bidi " << bidiFlag;
+    // with text, all pages text is decoded anyways
+    if(extractTables && !extractText)
+        options << " table-text " << tableTextDecoding;
+    return options.str();
+}
+
+CachedExtraction::ECacheUse CachedExtraction::GetLatestCacheUse() const {
+    return latestCacheUse;
+}
+
+const PageArenaStats& CachedExtraction::GetPageArenaStats() const {
+    return pageArenaStats;
+}
+
+EStatusCode CachedExtraction::Extract(const string& inFilePath, ExtractionResults& outResults) {
+    latestCacheUse = eCacheUseNone;
+    pageArenaStats = PageArenaStats();
+    LatestError.code = eErrorNone;
+    LatestError.description.clear();
+    outResults = ExtractionResults();
+
+    // a file that can't be hashed goes on without the cache, and if it can't be read either it's reported by the extraction
+    string key;
+    FileStamp stamp;
+    uint64_t contentHash;
+    bool useCache = cache && GetFileStamp(inFilePath, stamp) && ComputeFileContentHash(inFilePath, contentHash);
+    if(useCache) {
+        key = ExtractionResultCache::ComputeKey(contentHash, GetResultsOptions());
+        StringVector parts;
+        if(cache->Get(key, parts) && DecodeResults(parts, outResults)) {
+            latestCacheUse = eCacheUseHit;
+            return eSuccess;
+        }
+    }
+
+    EStatusCode status = extractTables ? ExtractTables(inFilePath, outResults) : ExtractText(inFilePath, outResults);
+    if(status != eSuccess || !useCache)
+        return status;
+
+    // results of a file that changed since it was hashed are not of the hashed content, so they're not kept
+    FileStamp extractedStamp;
+    if(!GetFileStamp(inFilePath, extractedStamp) || !(extractedStamp == stamp))
+        return status;
+
+    StringVector parts;
+    EncodeResults(outResults, parts);
+    latestCacheUse = cache->Put(key, parts) ? eCacheUseStored : eCacheUseStoreFailed;
+    return status;
+}
+
+EStatusCode CachedExtraction::ExtractText(const string& inFilePath, ExtractionResults& outResults) {
+    TextExtraction textExtraction;
+    textExtraction.SetFontPrefetchWorkers(fontPrefetchWorkersCount);
+    textExtraction.SetCompositionWorkers(compositionWorkersCount);
+    EStatusCode status = textExtraction.ExtractText(inFilePath, startPage, endPage);
+    pageArenaStats = textExtraction.GetPageArenaStats();
+    outResults.warnings = textExtraction.LatestWarnings;
+    if(status != eSuccess) {
+        LatestError = textExtraction.LatestError;
+        return status;
+    }
+
+    StringOutputSink sink(outResults.text);
+    OutputBuffer buffer(&sink);
+    textExtraction.GetResultsAsText(bidiFlag, spacing, buffer);
+    return buffer.Flush();
+}
+
+EStatusCode CachedExtraction::ExtractTables(const string& inFilePath, ExtractionResults& outResults) {
+    TableExtraction tableExtraction;
+    tableExtraction.SetFontPrefetchWorkers(fontPrefetchWorkersCount);
+    tableExtraction.SetCompositionWorkers(compositionWorkersCount);
+    tableExtraction.SetTextDecoding(extractText ? TableExtraction::eTextDecodingAllPages : tableTextDecoding);
+    tableExtraction.SetShouldKeepPageTexts(extractText);
+    EStatusCode status = tableExtraction.ExtractTables(inFilePath, startPage, endPage);
+    pageArenaStats = tableExtraction.GetPageArenaStats();
+    outResults.warnings = tableExtraction.LatestWarnings;
+    if(status != eSuccess) {
+        LatestError = tableExtraction.LatestError;
+        return status;
+    }
+
+    if(extractText) {
+        StringOutputSink sink(outResults.text);
+        OutputBuffer buffer(&sink);
+        tableExtraction.GetAllAsText(bidiFlag, spacing, buffer);
+        status = buffer.Flush();
+    }
+
+    // each table is composed to the same string, and copied out of it
+    string table;
+    StringOutputSink tableSink(table);
+    OutputBuffer tableBuffer(&tableSink, scTableBufferSize);
+    TableListList::const_iterator itPages = tableExtraction.tablesForPages.begin();
+    for(; itPages != tableExtraction.tablesForPages.end() && status == eSuccess; ++itPages) {
+        outResults.pagesTablesCounts.push_back(itPages->size());
+        TableList::const_iterator itTables = itPages->begin();
+        for(; itTables != itPages->end() && status == eSuccess; ++itTables) {
+            tableExtraction.GetTableAsCSVText(*itTables, bidiFlag, spacing, tableBuffer);
+            status = tableBuffer.Flush();
+            outResults.tables.push_back(table);
+            table.clear();
+        }
+    }
+    return status;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "EStatusCode.h"
+
+#include "ExtractionResultCache.h"
+#include "../../TableExtraction.h"
+#include "../text-composition/TextComposer.h"
+#include "../memory/PageArena.h"
+#include "../output/OutputBuffer.h"
+
+#include <string>
+#include <vector>
+
+typedef std::vector<size_t> SizeTVector;
+
+/**
+ * Composed extraction results - the text and tables CSVs, as TextExtraction and TableExtraction write them.
+ */
+struct ExtractionResults {
+    // the text, as TextExtraction::GetResultsAsText writes it. empty when extracting just tables
+    std::string text;
+    // tables CSVs in pages order, each as TableExtraction::GetTableAsCSVText writes it
+    StringVector tables;
+    // how many of the tables each page has
+    SizeTVector pagesTablesCounts;
+    ExtractionWarningList warnings;
+
+    // write all tables, as TableExtraction::GetAllAsCSVText would
+    void WriteAllTablesCSV(OutputBuffer& outBuffer) const;
+};
+
+/**
+ * Text and tables extraction from a file, through an ExtractionResultCache. Results are kept keyed by the file content and the
+ * options that change them (see GetResultsOptions - the library version and build options are added by the cache), so extracting
+ * the same content with the same options again - a retry, the same file under another name - gets them from the cache instead of
+ * interpreting the file again.
+ * Without a cache it just extracts. Cache failures are not extraction failures, GetLatestCacheUse tells about them.
+ */
+class CachedExtraction {
+    public:
+        enum ECacheUse {
+            eCacheUseNone, // no cache, or the file couldn't be hashed
+            eCacheUseHit, // the results came from the cache
+            eCacheUseStored, // the results were extracted, and stored in the cache
+            eCacheUseStoreFailed // the results were extracted, but couldn't be stored
+        };
+
+        // inCache should be open. NULL to extract without a cache
+        CachedExtraction(ExtractionResultCache* inCache);
+        ~CachedExtraction();
+
+        // pages range, as with TextExtraction::ExtractText. default is all pages
+        void SetPagesRange(long inStartPage, long inEndPage);
+        // as with TextExtraction::GetResultsAsText. default is -1 (no bidi) with eSpacingBoth
+        void SetComposition(int inBidiFlag, TextComposer::ESpacing inSpacing);
+        // extract text (the default), tables, or both in a single pass
+        void SetExtraction(bool inExtractText, bool inExtractTables);
+        // text decoding when extracting just tables, see TableExtraction::SetTextDecoding. with text, all pages text is decoded
+        void SetTableTextDecoding(TableExtraction::ETextDecoding inTextDecoding);
+        // workers don't change the results, see TextExtraction::SetFontPrefetchWorkers and SetCompositionWorkers
+        void SetFontPrefetchWorkers(unsigned int inWorkersCount);
+        void SetCompositionWorkers(unsigned int inWorkersCount);
+
+        PDFHummus::EStatusCode Extract(const std::string& inFilePath, ExtractionResults& outResults);
+
+        // options that make a difference to the results, and the entries format version, for the cache key
+        std::string GetResultsOptions() const;
+
+        ECacheUse GetLatestCacheUse() const;
+        // page interpretation arena counters of the latest extraction. zeros when the results came from the cache
+        const PageArenaStats& GetPageArenaStats() const;
+
+        ExtractionError LatestError;
+
+    private:
+        ExtractionResultCache* cache;
+        long startPage;
+        long endPage;
+        int bidiFlag;
+        TextComposer::ESpacing spacing;
+        bool extractText;
+        bool extractTables;
+        TableExtraction::ETextDecoding tableTextDecoding;
+        unsigned int fontPrefetchWorkersCount;
+        unsigned int compositionWorkersCount;
+
+        ECacheUse latestCacheUse;
+        PageArenaStats pageArenaStats;
+
+        PDFHummus::EStatusCode ExtractText(const std::string& inFilePath, ExtractionResults& outResults);
+        PDFHummus::EStatusCode ExtractTables(const std::string& inFilePath, ExtractionResults& outResults);
+};
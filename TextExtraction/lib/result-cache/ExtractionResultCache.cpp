@@ -0,0 +1,229 @@
+#include "ExtractionResultCache.h"
+
+#include "../hashing/ContentHash.h"
+#include "../memory/MappedFile.h"
+#include "../output/AtomicFileOutputSink.h"
+#include "../output/OutputBuffer.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const char scMagic[8] = {'E', 'X', 'R', 'E', 'S', 'U', 'L', 'T'};
+static const uint32_t scVersion = 1;
+// keys are two 64 bits hashes in hex, separated by a dash (see ComputeKey)
+static const size_t scKeyLength = 33;
+
+#ifndef TEXT_EXTRACTION_VERSION
+#define TEXT_EXTRACTION_VERSION "unknown"
+#endif
+
+// bidi support changes the text, compact coordinates change the placements, and internal tables are a default of table extraction
+static const string scBuildOptions = string("library ") + TEXT_EXTRACTION_VERSION
+#if (SUPPORT_ICU_BIDI==1)
+    + " bidi"
+#endif
+#ifdef COMPACT_PLACEMENT_COORDINATES
+    + " compact-placement-coordinates"
+#endif
+#ifdef SHOULD_PARSE_INTERNAL_TABLES
+    + " internal-tables"
+#endif
+    ;
+// temporary files this old are left over by writers that didn't get to commit them (see AtomicFileOutputSink)
+static const chrono::hours scAbandonedTemporaryFileAge(1);
+
+const string ExtractionResultCache::scResultsExtension = ".result";
+const string ExtractionResultCache::scPlacementsExtension = ".placements";
+
+struct ExtractionResultHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t partsCount;
+    // followed by the parts sizes (uint64 each), then the parts
+};
+
+ExtractionResultCache::ExtractionResultCache(const string& inDirectoryPath, uint64_t inMaximumSize) {
+    directoryPath = inDirectoryPath;
+    maximumSize = inMaximumSize;
+    entryExtensions.insert(scResultsExtension);
+    entryExtensions.insert(scPlacementsExtension);
+}
+
+ExtractionResultCache::~ExtractionResultCache() {
+}
+
+bool ExtractionResultCache::Open() {
+    error_code ignored;
+    filesystem::create_directories(directoryPath, ignored);
+    return filesystem::is_directory(directoryPath, ignored);
+}
+
+string ExtractionResultCache::ComputeKey(uint64_t inContentHash, const string& inOptions) {
+    ContentHasher optionsHasher(inContentHash);
+    optionsHasher.Update(scBuildOptions.data(), scBuildOptions.size());
+    optionsHasher.Update("\n", 1);
+    optionsHasher.Update(inOptions.data(), inOptions.size());
+
+    // same content shares the key prefix, so its entries for different options sit together
+    char key[scKeyLength + 1];
+    snprintf(key, sizeof(key), "%016llx-%016llx", (unsigned long long)inContentHash, (unsigned long long)optionsHasher.Digest());
+    return key;
+}
+
+const string& ExtractionResultCache::GetBuildOptions() {
+    return scBuildOptions;
+}
+
+string ExtractionResultCache::GetEntryPath(const string& inKey, const string& inExtension) {
+    entryExtensions.insert(inExtension);
+    return (filesystem::path(directoryPath) / (inKey + inExtension)).string();
+}
+
+bool ExtractionResultCache::Get(const string& inKey, StringVector& outParts) {
+    string entryPath = GetEntryPath(inKey, scResultsExtension);
+    MappedFile entry;
+    if(!entry.Open(entryPath))
+        return false;
+
+    const char* data = entry.GetData();
+    size_t size = entry.GetSize();
+    ExtractionResultHeader header;
+    if(size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if(memcmp(header.magic, scMagic, sizeof(scMagic)) != 0 || header.version != scVersion)
+        return false;
+
+    size_t offset = sizeof(header);
+    if(header.partsCount > (size - offset) / sizeof(uint64_t))
+        return false;
+    const char* partsSizes = data + offset;
+    offset += header.partsCount * sizeof(uint64_t);
+
+    StringVector parts(header.partsCount);
+    for(uint32_t i = 0; i < header.partsCount; ++i) {
+        uint64_t partSize;
+        memcpy(&partSize, partsSizes + i * sizeof(uint64_t), sizeof(partSize));
+        if(partSize > size - offset)
+            return false;
+        parts[i].assign(data + offset, (size_t)partSize);
+        offset += (size_t)partSize;
+    }
+    if(offset != size)
+        return false;
+
+    outParts.swap(parts);
+    Touch(entryPath);
+    return true;
+}
+
+bool ExtractionResultCache::Put(const string& inKey, const StringVector& inParts) {
+    {
+        AtomicFileOutputSink sink(GetEntryPath(inKey, scResultsExtension));
+        if(!sink.IsOpen())
+            return false;
+
+        ExtractionResultHeader header;
+        memcpy(header.magic, scMagic, sizeof(scMagic));
+        header.version = scVersion;
+        header.partsCount = (uint32_t)inParts.size();
+
+        OutputBuffer buffer(&sink);
+        buffer.Append((const char*)&header, sizeof(header));
+        StringVector::const_iterator it = inParts.begin();
+        for(; it != inParts.end(); ++it) {
+            uint64_t partSize = it->size();
+            buffer.Append((const char*)&partSize, sizeof(partSize));
+        }
+        for(it = inParts.begin(); it != inParts.end(); ++it)
+            buffer.Append(*it);
+
+        if(buffer.Flush() != eSuccess || !sink.Commit())
+            return false;
+    }
+
+    Evict();
+    return true;
+}
+
+void ExtractionResultCache::Touch(const string& inEntryPath) {
+    error_code ignored;
+    filesystem::last_write_time(inEntryPath, filesystem::file_time_type::clock::now(), ignored);
+}
+
+bool ExtractionResultCache::IsEntryFileName(const string& inFileName) const {
+    if(inFileName.size() <= scKeyLength || inFileName[scKeyLength / 2] != '-')
+        return false;
+    for(size_t i = 0; i < scKeyLength; ++i) {
+        if(i != scKeyLength / 2 && !isxdigit((unsigned char)inFileName[i]))
+            return false;
+    }
+    return entryExtensions.find(inFileName.substr(scKeyLength)) != entryExtensions.end();
+}
+
+struct CacheEntryFile {
+    filesystem::path path;
+    filesystem::file_time_type lastUsedTime;
+    uint64_t size;
+};
+
+static bool IsUsedEarlier(const CacheEntryFile& inLeft, const CacheEntryFile& inRight) {
+    return inLeft.lastUsedTime < inRight.lastUsedTime;
+}
+
+void ExtractionResultCache::Evict() {
+    vector<CacheEntryFile> entries;
+    uint64_t totalSize = 0;
+    filesystem::file_time_type now = filesystem::file_time_type::clock::now();
+
+    // errors just end the listing. entries may be removed meanwhile by other processes evicting them, which is fine
+    error_code listingError;
+    filesystem::directory_iterator it(directoryPath, listingError);
+    for(; !listingError && it != filesystem::directory_iterator(); it.increment(listingError)) {
+        error_code entryError;
+        if(!it->is_regular_file(entryError))
+            continue;
+
+        // only entries, and temporary files of entries, are the cache's to remove
+        string fileName = it->path().filename().string();
+        string targetFileName;
+        bool isTemporaryFile = AtomicFileOutputSink::GetTargetFilePath(fileName, targetFileName);
+        if(!IsEntryFileName(isTemporaryFile ? targetFileName : fileName))
+            continue;
+
+        CacheEntryFile entry;
+        entry.path = it->path();
+        entry.lastUsedTime = it->last_write_time(entryError);
+        entry.size = it->file_size(entryError);
+        if(entryError)
+            continue;
+
+        // temporary files are being written, unless abandoned long ago
+        if(isTemporaryFile) {
+            if(now - entry.lastUsedTime > scAbandonedTemporaryFileAge)
+                filesystem::remove(entry.path, entryError);
+            continue;
+        }
+
+        entries.push_back(entry);
+        totalSize += entry.size;
+    }
+
+    if(totalSize <= maximumSize)
+        return;
+
+    sort(entries.begin(), entries.end(), IsUsedEarlier);
+    vector<CacheEntryFile>::iterator itEntries = entries.begin();
+    for(; itEntries != entries.end() && totalSize > maximumSize; ++itEntries) {
+        error_code ignored;
+        filesystem::remove(itEntries->path, ignored);
+        totalSize -= itEntries->size;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+
+typedef std::vector<std::string> StringVector;
+
+/**
+ * Local directory cache of extraction results, so that a document extracted again with the same options (a retry, a duplicate
+ * under another name) gets its results from the cache instead of being interpreted again.
+ * Entries are keyed by a hash of the document content and of the extraction options (see ComputeKey). An entry is a list of parts,
+ * such as an extracted text and tables CSVs - or a file in a format of its own, such as a placements cache, using GetEntryPath.
+ * Entries are written atomically (see AtomicFileOutputSink), so processes may share a cache directory. Reading an entry marks it
+ * as recently used (by its modification time), and after writing entries the least recently used ones are evicted to keep the
+ * directory within its maximum size. Only entry files are evicted - results, placements caches, and files of the extensions this
+ * cache gave paths for - so other files in the directory are left alone, and don't count towards its size.
+ * Cache failures are never extraction failures - a cache that can't be read is a miss, and one that can't be written is skipped.
+ */
+class ExtractionResultCache {
+    public:
+        static const uint64_t scDefaultMaximumSize = 1024ULL * 1024 * 1024;
+        // extensions of entry files: results parts (Get/Put), and placements caches (see TextPlacementReader::write_cache)
+        static const std::string scResultsExtension;
+        static const std::string scPlacementsExtension;
+
+        ExtractionResultCache(const std::string& inDirectoryPath, uint64_t inMaximumSize = scDefaultMaximumSize);
+        ~ExtractionResultCache();
+
+        // create the cache directory if it doesn't exist. returns false if it can't be created
+        bool Open();
+
+        // key of results extracted from content with this hash (see ContentHash.h). inOptions should tell apart anything that changes
+        // the results (pages range, spacing and such), and the results format version. the library version and the build options
+        // that change results (see GetBuildOptions) are added to them, so builds sharing a directory don't use each other's results
+        static std::string ComputeKey(uint64_t inContentHash, const std::string& inOptions);
+        static const std::string& GetBuildOptions();
+
+        // read an entry parts. returns false on a miss
+        bool Get(const std::string& inKey, StringVector& outParts);
+        // write an entry, then evict as needed. returns false if the entry couldn't be written
+        bool Put(const std::string& inKey, const StringVector& inParts);
+
+        // path of an entry file of a format of its own, which inExtension tells apart from other entries of the key.
+        // call Touch after reading such a file, and Evict after writing it. Evict takes files of inExtension for entries from now on
+        std::string GetEntryPath(const std::string& inKey, const std::string& inExtension);
+        void Touch(const std::string& inEntryPath);
+        // remove least recently used entries till the directory is within the maximum size
+        void Evict();
+
+    private:
+        typedef std::set<std::string> StringSet;
+
+        std::string directoryPath;
+        uint64_t maximumSize;
+        StringSet entryExtensions;
+
+        bool IsEntryFileName(const std::string& inFileName) const;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Table.h"
+
+class IPageTablesHandler {
+
+    public:
+        // called with the tables of a page right after the page is interpreted and its tables composed. the tables may be
+        // moved out, they are dropped on return. return false to stop the extraction
+        virtual bool OnPageTablesComposed(unsigned long inPageIndex, TableList& refTables) = 0;
+};
@@ -0,0 +1,66 @@
+#include "IntervalTree.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+IntervalTree::IntervalTree() {
+    itemsCount = 0;
+}
+
+void IntervalTree::Add(double inLow, double inHigh) {
+    if(!isnan(inLow) && !isnan(inHigh)) {
+        Interval interval = {inLow, inHigh, itemsCount};
+        intervals.push_back(interval);
+    }
+    ++itemsCount;
+}
+
+void IntervalTree::Build() {
+    sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b){return a.low < b.low;});
+    maxHighs.resize(intervals.size());
+    BuildRange(0, intervals.size());
+}
+
+double IntervalTree::BuildRange(size_t inStart, size_t inEnd) {
+    if(inStart >= inEnd)
+        return -HUGE_VAL;
+
+    size_t middle = inStart + (inEnd - inStart)/2;
+    double maxHigh = intervals[middle].high;
+    double leftMaxHigh = BuildRange(inStart, middle);
+    double rightMaxHigh = BuildRange(middle + 1, inEnd);
+    if(leftMaxHigh > maxHigh)
+        maxHigh = leftMaxHigh;
+    if(rightMaxHigh > maxHigh)
+        maxHigh = rightMaxHigh;
+    maxHighs[middle] = maxHigh;
+    return maxHigh;
+}
+
+void IntervalTree::FindOverlapping(double inLow, double inHigh, vector<size_t>& outItems) const {
+    FindInRange(0, intervals.size(), inLow, inHigh, outItems);
+}
+
+void IntervalTree::FindInRange(size_t inStart, size_t inEnd, double inLow, double inHigh, vector<size_t>& outItems) const {
+    while(inStart < inEnd) {
+        size_t middle = inStart + (inEnd - inStart)/2;
+
+        // nothing in this sub range reaches the query range
+        if(!(maxHighs[middle] >= inLow))
+            return;
+
+        FindInRange(inStart, middle, inLow, inHigh, outItems);
+
+        // the middle and everything after it start after the query range ends
+        if(!(intervals[middle].low <= inHigh))
+            return;
+
+        if(intervals[middle].high >= inLow)
+            outItems.push_back(intervals[middle].item);
+
+        // continue to the right sub range
+        inStart = middle + 1;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Static interval tree over closed intervals. Intervals are added, the tree is built once, and then it's queried for the intervals
+ * overlapping a range in O(log n + k).
+ * Used to find the table lines around a cell - horizontal lines by their vertical extent, and vertical lines by their horizontal extent.
+ * The tree is implicit: intervals are sorted by their low end, the middle of every sub range is its node, and each node keeps the highest
+ * high end in its sub range so that queries can skip sub ranges that end before the query range.
+ */
+class IntervalTree {
+    public:
+        IntervalTree();
+
+        // add an interval. intervals are numbered in the order of adding them, starting with 0.
+        // an interval with a NaN end can't overlap anything, so it is not kept (but still gets its number)
+        void Add(double inLow, double inHigh);
+        // call when done adding, before querying
+        void Build();
+
+        // append the numbers of the intervals that overlap [inLow, inHigh] to outItems, in no particular order
+        void FindOverlapping(double inLow, double inHigh, std::vector<size_t>& outItems) const;
+
+    private:
+        struct Interval {
+            double low;
+            double high;
+            size_t item;
+        };
+        typedef std::vector<Interval> IntervalVector;
+        typedef std::vector<double> DoubleVector;
+
+        size_t itemsCount;
+        IntervalVector intervals;
+        DoubleVector maxHighs;
+
+        double BuildRange(size_t inStart, size_t inEnd);
+        void FindInRange(size_t inStart, size_t inEnd, double inLow, double inHigh, std::vector<size_t>& outItems) const;
+};
@@ -5,36 +5,40 @@
 
 #include <vector>
 #include <list>
+#include <memory>
 
 struct Table;
 
+typedef std::vector<size_t> TextPlacementIndexVector;
+
+/**
+ * Cells don't copy their texts. They hold the indexes of their texts in the page text placements, which the table
+ * keeps (Table::textPlacements). Internal tables are owned by their cell, so tables are moved around rather than copied.
+ */
 struct CellInRow {
-    CellInRow(): leftLine(), rightLine(),textPlacements() {
+    CellInRow(): leftLine(), rightLine() {
         colSpan = 1;
-        internalTable = NULL;
     }
 
     CellInRow(
         const ParsedLinePlacement& inLeftLine,
         const ParsedLinePlacement& inRightLine,
-        int inColSpan,
-        const ParsedTextPlacementList& inTextPlacements,
-        Table* inInternalTable): leftLine(inLeftLine), rightLine(inRightLine), textPlacements(inTextPlacements) {
+        int inColSpan): leftLine(inLeftLine), rightLine(inRightLine) {
             colSpan = inColSpan;
-            internalTable = inInternalTable;
     }
 
-    CellInRow(const CellInRow& inOther); // this one DUPLICATES the table
-
+    CellInRow(CellInRow&& inOther);
+    CellInRow& operator=(CellInRow&& inOther);
     ~CellInRow();
 
     ParsedLinePlacement leftLine;
     ParsedLinePlacement rightLine;
     int colSpan;
 
-    ParsedTextPlacementList textPlacements;
+    // indexes of the cell texts in the table text placements, in the page order
+    TextPlacementIndexVector textPlacementIndexes;
     
-    Table* internalTable; // oh this is causing much trouble...but fear not...we'll just duplicate it as intended
+    std::unique_ptr<Table> internalTable;
 };
 
 typedef std::vector<CellInRow> CellInRowVector;
@@ -50,7 +54,9 @@ typedef std::vector<Row> RowVector;
 
 struct Table {
     RowVector rows;
+
+    // the page text placements, which cells refer to by index. shared by the page tables and their internal tables
+    std::shared_ptr<const ParsedTextPlacementList> textPlacements;
 };
 
 typedef std::list<Table> TableList;
-
@@ -0,0 +1,128 @@
+#include "TableBoxIndex.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// grid is (up to) this many bins per table on each axis, so tables mostly get bins of their own
+static const size_t scBinsPerTable = 2;
+static const size_t scMaxBinsPerAxis = 64;
+
+TableBoxIndex::TableBoxIndex(const TableList& inTables) {
+    gridBox[0] = gridBox[1] = HUGE_VAL;
+    gridBox[2] = gridBox[3] = -HUGE_VAL;
+
+    TableList::const_iterator itTables = inTables.begin();
+    for(; itTables != inTables.end(); ++itTables) {
+        TableBox table;
+        table.box[0] = HUGE_VAL;
+        table.box[1] = itTables->rows.back().bottomLine.globalPointTwo[1];
+        table.box[2] = -HUGE_VAL;
+        table.box[3] = itTables->rows.front().topLine.globalPointOne[1];
+        RowVector::const_iterator itRows = itTables->rows.begin();
+        for(; itRows != itTables->rows.end(); ++itRows) {
+            if(itRows->cells.size() == 0)
+                continue;
+            if(itRows->cells.front().leftLine.globalPointOne[0] < table.box[0])
+                table.box[0] = itRows->cells.front().leftLine.globalPointOne[0];
+            if(itRows->cells.back().rightLine.globalPointTwo[0] > table.box[2])
+                table.box[2] = itRows->cells.back().rightLine.globalPointTwo[0];
+        }
+        tableBoxes.push_back(table);
+
+        // grid covers the (finite) coordinates of all tables
+        for(int i=0;i<4;++i) {
+            if(!isfinite(table.box[i]))
+                continue;
+            if(table.box[i] < gridBox[i%2])
+                gridBox[i%2] = table.box[i];
+            if(table.box[i] > gridBox[i%2 + 2])
+                gridBox[i%2 + 2] = table.box[i];
+        }
+    }
+
+    size_t binsPerAxis = (size_t)ceil(sqrt((double)tableBoxes.size())) * scBinsPerTable;
+    if(binsPerAxis > scMaxBinsPerAxis)
+        binsPerAxis = scMaxBinsPerAxis;
+    if(binsPerAxis < 1)
+        binsPerAxis = 1;
+    columnsCount = binsPerAxis;
+    rowsCount = binsPerAxis;
+    binWidth = (gridBox[2] - gridBox[0]) / columnsCount;
+    binHeight = (gridBox[3] - gridBox[1]) / rowsCount;
+    bins.resize(columnsCount * rowsCount);
+
+    for(size_t i=0;i<tableBoxes.size();++i) {
+        // list the table in all bins between its min and max coordinates. like with text boxes, an inverted table box
+        // may still intersect a text box spanning its inverted range
+        const double (&box)[4] = tableBoxes[i].box;
+        size_t firstColumn = GetColumn(box[0] < box[2] ? box[0] : box[2]);
+        size_t lastColumn = GetColumn(box[0] < box[2] ? box[2] : box[0]);
+        size_t firstRow = GetRow(box[1] < box[3] ? box[1] : box[3]);
+        size_t lastRow = GetRow(box[1] < box[3] ? box[3] : box[1]);
+        for(size_t row = firstRow; row <= lastRow; ++row) {
+            for(size_t column = firstColumn; column <= lastColumn; ++column)
+                bins[row * columnsCount + column].push_back(i);
+        }
+    }
+}
+
+size_t TableBoxIndex::GetColumn(double inX) const {
+    // bins are clamped to the grid, and not (strictly) positive widths map everything to the first bin
+    if(!(binWidth > 0) || !(inX > gridBox[0]))
+        return 0;
+    double column = floor((inX - gridBox[0]) / binWidth);
+    return column >= columnsCount ? columnsCount - 1 : (size_t)column;
+}
+
+size_t TableBoxIndex::GetRow(double inY) const {
+    if(!(binHeight > 0) || !(inY > gridBox[1]))
+        return 0;
+    double row = floor((inY - gridBox[1]) / binHeight);
+    return row >= rowsCount ? rowsCount - 1 : (size_t)row;
+}
+
+bool TableBoxIndex::DoesIntersectTable(const double (&inBox)[4], size_t inTableIndex) const {
+    // phrased as the negation of the table checks that rule out a text, so that a NaN coordinate doesn't rule out anything
+    const double (&tableBox)[4] = tableBoxes[inTableIndex].box;
+    return !(tableBox[3] < inBox[1]) &&
+            !(tableBox[1] > inBox[3]) &&
+            !(tableBox[0] > inBox[2]) &&
+            !(tableBox[2] < inBox[0]);
+}
+
+void TableBoxIndex::FindTables(const double (&inBox)[4], vector<size_t>& outTables) const {
+    outTables.clear();
+
+    if(isnan(inBox[0]) || isnan(inBox[1]) || isnan(inBox[2]) || isnan(inBox[3])) {
+        for(size_t i=0;i<tableBoxes.size();++i) {
+            if(DoesIntersectTable(inBox, i))
+                outTables.push_back(i);
+        }
+        return;
+    }
+
+    // an inverted box can still be in a table that spans its whole inverted range, so look at bins between its min and max
+    size_t firstColumn = GetColumn(inBox[0] < inBox[2] ? inBox[0] : inBox[2]);
+    size_t lastColumn = GetColumn(inBox[0] < inBox[2] ? inBox[2] : inBox[0]);
+    size_t firstRow = GetRow(inBox[1] < inBox[3] ? inBox[1] : inBox[3]);
+    size_t lastRow = GetRow(inBox[1] < inBox[3] ? inBox[3] : inBox[1]);
+
+    for(size_t row = firstRow; row <= lastRow; ++row) {
+        for(size_t column = firstColumn; column <= lastColumn; ++column) {
+            const SizeTVector& bin = bins[row * columnsCount + column];
+            SizeTVector::const_iterator it = bin.begin();
+            for(; it != bin.end(); ++it) {
+                if(DoesIntersectTable(inBox, *it))
+                    outTables.push_back(*it);
+            }
+        }
+    }
+
+    if(firstRow != lastRow || firstColumn != lastColumn) {
+        // a table may be listed in more than one of the bins
+        sort(outTables.begin(), outTables.end());
+        outTables.erase(unique(outTables.begin(), outTables.end()), outTables.end());
+    }
+}
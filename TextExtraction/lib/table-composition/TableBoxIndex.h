@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Table.h"
+
+#include <vector>
+
+/**
+ * Grid index of the boxes of a page tables. Used to find the tables that a text may belong to without going through all
+ * of the page tables for each text.
+ * A table box is the range of its rows top to bottom lines, and its cells leftmost to rightmost lines. A text can only
+ * be placed in a table if its box intersects the table box.
+ */
+class TableBoxIndex {
+    public:
+        TableBoxIndex(const TableList& inTables);
+
+        // get the indexes of tables whose box intersects inBox, in the tables order.
+        // a box with NaN coordinates can't be ruled out of any table, so it gets all of them
+        void FindTables(const double (&inBox)[4], std::vector<size_t>& outTables) const;
+
+    private:
+        typedef std::vector<size_t> SizeTVector;
+        typedef std::vector<SizeTVector> SizeTVectorVector;
+
+        struct TableBox {
+            double box[4];
+        };
+        typedef std::vector<TableBox> TableBoxVector;
+
+        TableBoxVector tableBoxes;
+
+        // grid over the union of table boxes. each bin lists the tables whose box intersects it
+        double gridBox[4];
+        size_t columnsCount;
+        size_t rowsCount;
+        double binWidth;
+        double binHeight;
+        SizeTVectorVector bins;
+
+        size_t GetColumn(double inX) const;
+        size_t GetRow(double inY) const;
+        bool DoesIntersectTable(const double (&inBox)[4], size_t inTableIndex) const;
+};
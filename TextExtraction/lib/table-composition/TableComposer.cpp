@@ -1,11 +1,14 @@
 #include "TableComposer.h"
+#include "TableBoxIndex.h"
+#include "IntervalTree.h"
 
-#include "../graphs/Graph.h"
+#include "../graphs/DisjointSets.h"
 #include "../graphs/Result.h"
 #include "../math/Transformations.h"
 
 #include <set>
 #include <map>
+#include <unordered_set>
 #include <algorithm>
 #include <vector>
 #include <math.h>
@@ -19,7 +22,7 @@ TableComposer::TableComposer() {
  * as boolean might not be the most efficient ways of implementing this, but it does allow me
  * to compile the parsing part...which i couldn't if i ifdefed the whole recursion section at CreateTable.
  * 
- * so - compile flag determines this boolean consulted in code.
+ * so - compile flag determines the default of this boolean consulted in code, and SetShouldParseInternalTables can change it at runtime.
  * 
  * why not do it (which is the default)? cause CSV output cant really use it and that's the only current output. so we can save some time.
  * why do it? cause it gives enough information to all defining split cells if outputting to some more sophisticated spreadsheet (like Excel, Google sheet, numbers)
@@ -36,6 +39,10 @@ TableComposer::~TableComposer() {
 
 }
 
+void TableComposer::SetShouldParseInternalTables(bool inShouldParseInternalTables) {
+    shouldParseInternalTables = inShouldParseInternalTables;
+}
+
 
 #define INTERSECT_THRESHOLD 1
 
@@ -133,83 +140,225 @@ bool CompareVerticalLines(const ParsedLinePlacement& a, const ParsedLinePlacemen
 }
 
 
-typedef GraphNode<const ParsedLinePlacement*> ParsedLinePlacementGraphNode;
-typedef map<const ParsedLinePlacement*, ParsedLinePlacementGraphNode*> ParsedLinePlacementToParsedLinePlacementGraphNodeMap;
-typedef set<ParsedLinePlacementGraphNode*> ParsedLinePlacementGraphNodeSet;
-
+typedef vector<const ParsedLinePlacement*> ParsedLinePlacementPtrVector;
 
-void CreateNodesForLinesList(
-    const ParsedLinePlacementList& inList, 
-    ParsedLinePlacementToParsedLinePlacementGraphNodeMap& refMap, 
-    ParsedLinePlacementGraphNodeSet& refNodes
-) {
+void ListLines(const ParsedLinePlacementList& inList, ParsedLinePlacementPtrVector& refLines) {
     ParsedLinePlacementList::const_iterator it = inList.begin();
-    for(; it != inList.end();++it) {
-        const ParsedLinePlacement* item = &(*it);
-        ParsedLinePlacementGraphNode* node = new ParsedLinePlacementGraphNode();
-        node->value = item;
-        refMap.insert(ParsedLinePlacementToParsedLinePlacementGraphNodeMap::value_type(item, node ));
-        refNodes.insert(node);
+    for(; it != inList.end();++it)
+        refLines.push_back(&(*it));
+}
+
+/**
+ * Intersections are found in two steps - a sweep that finds candidate pairs, and then the intersection tests above
+ * on the candidates, so which lines intersect is decided exactly as before. Candidate bounds are loosened by a tiny bit so that
+ * rounding differences between the sweep bounds and the tests can't lose an intersection.
+ */
+static const double scSweepSlack = 1e-9;
+
+double LoosenDown(double inValue) {
+    return isfinite(inValue) ? inValue - scSweepSlack * (1 + fabs(inValue)) : inValue;
+}
+
+double LoosenUp(double inValue) {
+    return isfinite(inValue) ? inValue + scSweepSlack * (1 + fabs(inValue)) : inValue;
+}
+
+enum ESweepEventType {
+    eSweepEventStart = 0,
+    eSweepEventQuery = 1,
+    eSweepEventEnd = 2
+};
+
+struct SweepEvent {
+    SweepEvent(double inPosition, ESweepEventType inType, size_t inIndex) {
+        position = inPosition;
+        type = inType;
+        index = inIndex;
     }
+
+    double position;
+    ESweepEventType type;
+    size_t index;
+};
+
+typedef vector<SweepEvent> SweepEventVector;
+typedef pair<double, size_t> PositionAndIndex;
+typedef set<PositionAndIndex> PositionAndIndexSet;
+
+bool CompareSweepEvents(const SweepEvent& a, const SweepEvent& b) {
+    // at the same position, starts go before queries and queries before ends, so touching ranges count
+    if(a.position != b.position)
+        return a.position < b.position;
+    if(a.type != b.type)
+        return a.type < b.type;
+    return a.index < b.index;
 }
 
-void CreateEdgesForLinesList(
-    const ParsedLinePlacementList& inHorizontalList,
-    const ParsedLinePlacementList& inVerticalList,
+void UniteCrossingLines(
+    const ParsedLinePlacementPtrVector& inHorizontalLines,
+    const ParsedLinePlacementPtrVector& inVerticalLines,
     const double (&inScopeBox)[4],
-    ParsedLinePlacementToParsedLinePlacementGraphNodeMap& refMap
+    DisjointSets& refLineSets
 ) {
-    
-    // check horizontal vs. vertical intersection
-    ParsedLinePlacementList::const_iterator itHorizontal = inHorizontalList.begin();
-    for(; itHorizontal != inHorizontalList.end();++itHorizontal) {
-        ParsedLinePlacementList::const_iterator itVertical = inVerticalList.begin();
-        for(; itVertical != inVerticalList.end();++itVertical) {
-            if(HorizontalIntersectsWithVertical(*itHorizontal, *itVertical, inScopeBox)) {
-                ParsedLinePlacementGraphNode* horNode = refMap[&(*itHorizontal)];
-                ParsedLinePlacementGraphNode* verNode = refMap[&(*itVertical)];
-                horNode->neighbors.push_back(verNode);
-                verNode->neighbors.push_back(horNode);
-            }
-        }
+    // sweep bottom to top. vertical lines are active while the sweep is within their Y range, and each horizontal line
+    // looks up the active vertical lines whose X is within its X range.
+    // a line width affects both lines ranges in the intersection test, so ranges here are extended by the widest width
+    // of the other kind of lines, which keeps lookups to a single coordinate.
+    double maxHorizontalHalfWidth = 0;
+    double maxVerticalHalfWidth = 0;
+    for(size_t i=0;i<inHorizontalLines.size();++i) {
+        if(inHorizontalLines[i]->effectiveLineWidth[1]/2 > maxHorizontalHalfWidth)
+            maxHorizontalHalfWidth = inHorizontalLines[i]->effectiveLineWidth[1]/2;
+    }
+    for(size_t i=0;i<inVerticalLines.size();++i) {
+        if(inVerticalLines[i]->effectiveLineWidth[0]/2 > maxVerticalHalfWidth)
+            maxVerticalHalfWidth = inVerticalLines[i]->effectiveLineWidth[0]/2;
     }
 
-    // check horizontal vs. horizontal intersection
-    ParsedLinePlacementList::const_iterator itHorizontal1 = inHorizontalList.begin();
-    for(; itHorizontal1 != inHorizontalList.end();++itHorizontal1) {
-        ParsedLinePlacementList::const_iterator itHorizontal2 = inHorizontalList.begin();
-        for(; itHorizontal2 != inHorizontalList.end();++itHorizontal2) {
-            if((&(*itHorizontal1)) == (&(*itHorizontal2)))
+    // lines with NaN coordinates fail the intersection test regardless, so they are just left out
+    SweepEventVector events;
+    for(size_t i=0;i<inVerticalLines.size();++i) {
+        const ParsedLinePlacement* line = inVerticalLines[i];
+        double bottom = LoosenDown(line->globalPointTwo[1] - line->effectiveLineWidth[1]/2 - INTERSECT_THRESHOLD - maxHorizontalHalfWidth);
+        double top = LoosenUp(line->globalPointOne[1] + line->effectiveLineWidth[1]/2 + INTERSECT_THRESHOLD + maxHorizontalHalfWidth);
+        if(!(bottom <= top) || isnan(line->globalPointOne[0]))
+            continue;
+        events.push_back(SweepEvent(bottom, eSweepEventStart, i));
+        events.push_back(SweepEvent(top, eSweepEventEnd, i));
+    }
+    if(events.size() == 0)
+        return;
+    for(size_t i=0;i<inHorizontalLines.size();++i) {
+        if(isnan(inHorizontalLines[i]->globalPointOne[1]))
+            continue;
+        events.push_back(SweepEvent(inHorizontalLines[i]->globalPointOne[1], eSweepEventQuery, i));
+    }
+    sort(events.begin(), events.end(), CompareSweepEvents);
+
+    PositionAndIndexSet activeVerticals;
+    SweepEventVector::iterator itEvents = events.begin();
+    for(; itEvents != events.end(); ++itEvents) {
+        if(itEvents->type == eSweepEventStart) {
+            activeVerticals.insert(PositionAndIndex(inVerticalLines[itEvents->index]->globalPointOne[0], itEvents->index));
+        } else if(itEvents->type == eSweepEventEnd) {
+            activeVerticals.erase(PositionAndIndex(inVerticalLines[itEvents->index]->globalPointOne[0], itEvents->index));
+        } else {
+            const ParsedLinePlacement* horizontal = inHorizontalLines[itEvents->index];
+            double left = LoosenDown(horizontal->globalPointOne[0] - horizontal->effectiveLineWidth[0]/2 - INTERSECT_THRESHOLD - maxVerticalHalfWidth);
+            double right = LoosenUp(horizontal->globalPointTwo[0] + horizontal->effectiveLineWidth[0]/2 + INTERSECT_THRESHOLD + maxVerticalHalfWidth);
+            if(!(left <= right))
                 continue;
 
-            if(HorizontalIntersectsWithHorizontal(*itHorizontal1, *itHorizontal2, inScopeBox)) {
-                ParsedLinePlacementGraphNode* horNode1 = refMap[&(*itHorizontal1)];
-                ParsedLinePlacementGraphNode* horNode2 = refMap[&(*itHorizontal2)];
-
-                horNode1->neighbors.push_back(horNode2);
-                horNode2->neighbors.push_back(horNode1);
+            PositionAndIndexSet::iterator it = activeVerticals.lower_bound(PositionAndIndex(left, 0));
+            for(; it != activeVerticals.end() && it->first <= right; ++it) {
+                if(HorizontalIntersectsWithVertical(*horizontal, *inVerticalLines[it->second], inScopeBox))
+                    refLineSets.Union(itEvents->index, inHorizontalLines.size() + it->second);
             }
         }
-    }    
+    }
+}
 
+// a line in terms of continuance along its direction. for horizontal lines this is their Y, and their X from left to right.
+// vertical lines use X, and their negated Y from top to bottom, so that both can run through the same code
+struct CollinearSegment {
+    double line;
+    double start;
+    double end;
+    size_t index;
+};
+
+typedef vector<CollinearSegment> CollinearSegmentVector;
+
+bool CompareCollinearSegments(const CollinearSegment& a, const CollinearSegment& b) {
+    if(a.line != b.line)
+        return a.line < b.line;
+    if(a.start != b.start)
+        return a.start < b.start;
+    return a.index < b.index;
+}
 
-    // check vertical vs. vertical intersection
-    ParsedLinePlacementList::const_iterator itVertical1 = inVerticalList.begin();
-    for(; itVertical1 != inVerticalList.end();++itVertical1) {
-        ParsedLinePlacementList::const_iterator itVertical2 = inVerticalList.begin();
-        for(; itVertical2 != inVerticalList.end();++itVertical2) {
-            if((&(*itVertical1)) == (&(*itVertical2)))
-                continue;
+typedef bool (*SameDirectionIntersectionTest)(const ParsedLinePlacement&, const ParsedLinePlacement&, const double (&)[4]);
 
+void UniteCollinearLines(
+    CollinearSegmentVector& refSegments,
+    const ParsedLinePlacementPtrVector& inLines,
+    size_t inSetsOffset,
+    SameDirectionIntersectionTest inIntersectionTest,
+    const double (&inScopeBox)[4],
+    DisjointSets& refLineSets
+) {
+    // same direction lines only intersect when on the exact same line, and then when one starts within the other (within threshold).
+    // per line, sweep the segments by their start. a segment is a candidate for the following segments while their start is
+    // within its reach (end + threshold), or when their start is within threshold from its start.
+    sort(refSegments.begin(), refSegments.end(), CompareCollinearSegments);
+
+    size_t groupStart = 0;
+    while(groupStart < refSegments.size()) {
+        size_t groupEnd = groupStart + 1;
+        while(groupEnd < refSegments.size() && refSegments[groupEnd].line == refSegments[groupStart].line)
+            ++groupEnd;
+
+        PositionAndIndexSet activeSegments; // by reach. index is into refSegments
+        for(size_t j=groupStart;j<groupEnd;++j) {
+            const CollinearSegment& segment = refSegments[j];
+
+            // drop segments that end before this one starts. starts only go up, so they won't be candidates again
+            while(!activeSegments.empty() && activeSegments.begin()->first < segment.start)
+                activeSegments.erase(activeSegments.begin());
+
+            PositionAndIndexSet::iterator it = activeSegments.begin();
+            for(; it != activeSegments.end(); ++it) {
+                if(inIntersectionTest(*inLines[refSegments[it->second].index], *inLines[segment.index], inScopeBox))
+                    refLineSets.Union(inSetsOffset + refSegments[it->second].index, inSetsOffset + segment.index);
+            }
 
-            if(VerticalIntersectsWithVertical(*itVertical1, *itVertical2, inScopeBox)) {
-                ParsedLinePlacementGraphNode* verNode1 = refMap[&(*itVertical1)];
-                ParsedLinePlacementGraphNode* verNode2 = refMap[&(*itVertical2)];
-                verNode1->neighbors.push_back(verNode2);
-                verNode2->neighbors.push_back(verNode1);
+            // segments starting close enough behind this one, that were not active
+            double windowStart = segment.start - INTERSECT_THRESHOLD;
+            for(size_t k=j;k>groupStart && refSegments[k-1].start >= windowStart;--k) {
+                const CollinearSegment& previous = refSegments[k-1];
+                if(previous.end + INTERSECT_THRESHOLD >= segment.start)
+                    continue; // active, so already tested
+                if(inIntersectionTest(*inLines[previous.index], *inLines[segment.index], inScopeBox))
+                    refLineSets.Union(inSetsOffset + previous.index, inSetsOffset + segment.index);
             }
+
+            double reach = segment.end + INTERSECT_THRESHOLD;
+            if(!isnan(reach))
+                activeSegments.insert(PositionAndIndex(reach, j));
         }
+
+        groupStart = groupEnd;
+    }
+}
+
+void UniteIntersectingLines(
+    const ParsedLinePlacementPtrVector& inHorizontalLines,
+    const ParsedLinePlacementPtrVector& inVerticalLines,
+    const double (&inScopeBox)[4],
+    DisjointSets& refLineSets
+) {
+    // sets hold the horizontal lines first, and then the vertical lines
+
+    // check horizontal vs. vertical intersection
+    UniteCrossingLines(inHorizontalLines, inVerticalLines, inScopeBox, refLineSets);
+
+    // check horizontal vs. horizontal intersection. lines with NaN Y or start never intersect anything, so they're left out
+    CollinearSegmentVector segments;
+    for(size_t i=0;i<inHorizontalLines.size();++i) {
+        CollinearSegment segment = {inHorizontalLines[i]->globalPointOne[1], inHorizontalLines[i]->globalPointOne[0], inHorizontalLines[i]->globalPointTwo[0], i};
+        if(!isnan(segment.line) && !isnan(segment.start))
+            segments.push_back(segment);
+    }
+    UniteCollinearLines(segments, inHorizontalLines, 0, HorizontalIntersectsWithHorizontal, inScopeBox, refLineSets);
+
+    // check vertical vs. vertical intersection
+    segments.clear();
+    for(size_t i=0;i<inVerticalLines.size();++i) {
+        CollinearSegment segment = {inVerticalLines[i]->globalPointOne[0], -inVerticalLines[i]->globalPointOne[1], -inVerticalLines[i]->globalPointTwo[1], i};
+        if(!isnan(segment.line) && !isnan(segment.start))
+            segments.push_back(segment);
     }
+    UniteCollinearLines(segments, inVerticalLines, inHorizontalLines.size(), VerticalIntersectsWithVertical, inScopeBox, refLineSets);
 }
 
 LinesList DetermineTablesLines(const Lines& inLines, const double (&inScopeBox)[4]) {
@@ -218,93 +367,95 @@ LinesList DetermineTablesLines(const Lines& inLines, const double (&inScopeBox)[
     // vertical lines...then group all those vertical lines and horizontal lines that interesect with the same ones
     // and call it a day. however...given the existance of split cells (colspan > 1 for our html friends)
     // not all horizontal lines intersect with all vertical lines and so we need an approach that will support transitivity.
-    // so - graphs. 
-    // by repeatedly running BFS we can determine separate groups of lines that connect (transivitly intersect)...and if there
+    // so - union find. every intersection unites the two lines sets, and in the end lines with a common root
+    // transitively intersect. if there are
     // enough lines to form cells (>1 hor and >1 ver) we can consider this as a table. the outcome of this method is a lis of Lines
     // struct each forming such table
-    ParsedLinePlacementToParsedLinePlacementGraphNodeMap linesToNodes;
-    ParsedLinePlacementGraphNodeSet unvisitedNodes;
+    ParsedLinePlacementPtrVector horizontalLines;
+    ParsedLinePlacementPtrVector verticalLines;
     LinesList result;
 
-    // build graph
-    CreateNodesForLinesList(inLines.horizontalLines, linesToNodes, unvisitedNodes);
-    CreateNodesForLinesList(inLines.verticalLines, linesToNodes, unvisitedNodes);
-    CreateEdgesForLinesList(inLines.horizontalLines, inLines.verticalLines, inScopeBox, linesToNodes);
-
-    // while nodes set is not empty, determine subgraph of a candidate node and remove from node set, till
-    // all nodes are accounted for, resulting in a tables lines list
-    while(unvisitedNodes.size() > 0) {
-        ParsedLinePlacementGraphNode* candidate =  *unvisitedNodes.begin();
-        ParsedLinePlacementGraphNodeSet intersectionSubGraph = FindReachableNodes(candidate);
-        
-        Lines resultCandidate;
-        ParsedLinePlacementGraphNodeSet::iterator it = intersectionSubGraph.begin();
-        for(; it != intersectionSubGraph.end(); ++it) {
-            if((*it)->value->isVertical)
-                resultCandidate.verticalLines.push_back(*((*it)->value));
-            else
-                resultCandidate.horizontalLines.push_back(*((*it)->value));
+    ListLines(inLines.horizontalLines, horizontalLines);
+    ListLines(inLines.verticalLines, verticalLines);
+
+    size_t linesCount = horizontalLines.size() + verticalLines.size();
+    DisjointSets lineSets(linesCount);
+    UniteIntersectingLines(horizontalLines, verticalLines, inScopeBox, lineSets);
+
+    // group lines per root, in one pass. groups are ordered by their first line, and lines keep the input order within them
+    static const size_t scNoGroup = (size_t)-1;
+    vector<size_t> rootGroups(linesCount, scNoGroup);
+    vector<Lines> groups;
+    for(size_t i=0;i<linesCount;++i) {
+        size_t root = lineSets.Find(i);
+        if(rootGroups[root] == scNoGroup) {
+            rootGroups[root] = groups.size();
+            groups.push_back(Lines());
         }
-
-        if(resultCandidate.horizontalLines.size() > 1 && resultCandidate.verticalLines.size() > 1)
-            result.push_back(resultCandidate);
-
-        ParsedLinePlacementGraphNodeSet stillUnvisited;
-        set_difference(
-            unvisitedNodes.begin(), 
-            unvisitedNodes.end(), 
-            intersectionSubGraph.begin(), 
-            intersectionSubGraph.end(), 
-            inserter(stillUnvisited, stillUnvisited.begin())
-        );
-        unvisitedNodes = stillUnvisited;
-       
+        Lines& group = groups[rootGroups[root]];
+        const ParsedLinePlacement* line = i < horizontalLines.size() ? horizontalLines[i] : verticalLines[i - horizontalLines.size()];
+        if(line->isVertical)
+            group.verticalLines.push_back(*line);
+        else
+            group.horizontalLines.push_back(*line);
     }
 
-    // release graph nodes
-    ParsedLinePlacementToParsedLinePlacementGraphNodeMap::iterator it = linesToNodes.begin();
-    for(; it != linesToNodes.end();++it) {
-        delete it->second;
+    vector<Lines>::iterator itGroups = groups.begin();
+    for(; itGroups != groups.end(); ++itGroups) {
+        if(itGroups->horizontalLines.size() > 1 && itGroups->verticalLines.size() > 1)
+            result.push_back(move(*itGroups));
     }
+
     return result;
 }
 
 typedef vector<ParsedLinePlacement> ParsedLinePlacementVector;
+typedef vector<size_t> SizeTVector;
+
 
+/**
+ * interval trees over a table lines, for finding the lines of each of its cells. horizontal lines are indexed by their
+ * vertical extent, and vertical lines by their horizontal extent - so a query gets the lines in the cell row (or column) band,
+ * and these are filtered for the other axis.
+ */
+struct TableLinesIndex {
+    IntervalTree horizontalLines;
+    IntervalTree verticalLines;
+};
+
+void BuildTableLinesIndex(
+    const ParsedLinePlacementVector& inSortedHorizontalLines,
+    const ParsedLinePlacementVector& inSortedVerticalLines,
+    TableLinesIndex& outIndex
+) {
+    ParsedLinePlacementVector::const_iterator it = inSortedHorizontalLines.begin();
+    for(; it != inSortedHorizontalLines.end(); ++it)
+        outIndex.horizontalLines.Add(it->globalPointOne[1] - it->effectiveLineWidth[1], it->globalPointOne[1] + it->effectiveLineWidth[1]);
+    outIndex.horizontalLines.Build();
+
+    it = inSortedVerticalLines.begin();
+    for(; it != inSortedVerticalLines.end(); ++it)
+        outIndex.verticalLines.Add(it->globalPointOne[0] - it->effectiveLineWidth[0], it->globalPointOne[0] + it->effectiveLineWidth[0]);
+    outIndex.verticalLines.Build();
+}
 
 Lines ComputeCellInternalLines(
-    const ParsedLinePlacementVector& insortedHorizontalLines, 
-    const ParsedLinePlacementVector&  inSortedVerticalLines, 
+    const ParsedLinePlacementVector& inSortedHorizontalLines, 
+    const ParsedLinePlacementVector& inSortedVerticalLines, 
+    const TableLinesIndex& inLinesIndex,
     const double (&inCellBox)[4]
 ) { 
     Lines result;
+    SizeTVector lineIndexes;
 
-    // This leaves much room for improvement...i got the lines sorted...can do binary search instead of iterating all.
-    // rmmbr this is done on a PER CELL basis.
-    // binary searching to make me feel better about this.
-
-
-    // horizontal lines first
-    int start = 0;
-    int end = insortedHorizontalLines.size();
-
-    // binary search the highest horizontal line that's lower than the box top
-    while(end - start > 1) {
-        int candidateIndex = start + floor((end - start)/2.0);
-
-        if(insortedHorizontalLines[candidateIndex].globalPointOne[1] - insortedHorizontalLines[candidateIndex].effectiveLineWidth[1]  > inCellBox[3] + INTERSECT_THRESHOLD) {
-            start = candidateIndex + 1;
-        } else {
-            end = candidateIndex;
-        }
-    }
-
-    for(int i=start; i<insortedHorizontalLines.size(); ++i) {
-        const ParsedLinePlacement& theLine = insortedHorizontalLines[i];
+    // horizontal lines first. the index gets the ones that are neither too high nor too low
+    inLinesIndex.horizontalLines.FindOverlapping(inCellBox[1] - INTERSECT_THRESHOLD, inCellBox[3] + INTERSECT_THRESHOLD, lineIndexes);
+    // keep the lines order, top to bottom
+    sort(lineIndexes.begin(), lineIndexes.end());
 
-        // horizontal line is too low...can stop now
-        if (theLine.globalPointOne[1] + theLine.effectiveLineWidth[1]  < inCellBox[1] - INTERSECT_THRESHOLD)
-            break;
+    SizeTVector::iterator itIndexes = lineIndexes.begin();
+    for(; itIndexes != lineIndexes.end(); ++itIndexes) {
+        const ParsedLinePlacement& theLine = inSortedHorizontalLines[*itIndexes];
 
         // too much to the left
         if(theLine.globalPointTwo[0] + theLine.effectiveLineWidth[0] < inCellBox[0] - INTERSECT_THRESHOLD)
@@ -318,27 +469,15 @@ Lines ComputeCellInternalLines(
         result.horizontalLines.push_back(theLine);
     }
 
-    // now for vertical lines
-    start = 0;
-    end = inSortedVerticalLines.size();
-
-    // binary search the leftest vertical line that's righter than the box left
-    while(end - start > 1) {
-        int candidateIndex = start + floor((end - start)/2.0);
-
-        if(inSortedVerticalLines[candidateIndex].globalPointOne[0] + inSortedVerticalLines[candidateIndex].effectiveLineWidth[0] < inCellBox[0] - INTERSECT_THRESHOLD) {
-            start = candidateIndex + 1;
-        } else {
-            end = candidateIndex;
-        }
-    }    
-
-    for(int i=start; i<inSortedVerticalLines.size(); ++i) {
-        const ParsedLinePlacement& theLine = inSortedVerticalLines[i];
+    // now for vertical lines. the index gets the ones that are neither too much to the left nor to the right
+    lineIndexes.clear();
+    inLinesIndex.verticalLines.FindOverlapping(inCellBox[0] - INTERSECT_THRESHOLD, inCellBox[2] + INTERSECT_THRESHOLD, lineIndexes);
+    // keep the lines order, left to right
+    sort(lineIndexes.begin(), lineIndexes.end());
 
-        // too much to the right, can stop now
-        if(theLine.globalPointOne[0] - theLine.effectiveLineWidth[0] > inCellBox[2] + INTERSECT_THRESHOLD)
-            break;
+    itIndexes = lineIndexes.begin();
+    for(; itIndexes != lineIndexes.end(); ++itIndexes) {
+        const ParsedLinePlacement& theLine = inSortedVerticalLines[*itIndexes];
 
         // too high
         if(theLine.globalPointTwo[1] - theLine.effectiveLineWidth[1] > inCellBox[3] + INTERSECT_THRESHOLD)
@@ -366,68 +505,134 @@ bool AreLinesEqual(const ParsedLinePlacement& inA, const ParsedLinePlacement& in
 }
 
 
-Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], bool inShouldParseInternalTables) {
-    Table result;
+double NormalizeZero(double inValue) {
+    // -0 and 0 are equal lines, so they should hash the same
+    return inValue == 0 ? 0 : inValue;
+}
 
-    ParsedLinePlacementVector sortedHorizontalLines(inLines.horizontalLines.begin(), inLines.horizontalLines.end());
-    sort(sortedHorizontalLines.begin(), sortedHorizontalLines.end(), CompareHorizontalLines);
-    for(size_t i=sortedHorizontalLines.size()-1;i>0;--i) {
-        if(
-            sortedHorizontalLines[i].globalPointOne[1] == sortedHorizontalLines[i-1].globalPointOne[1] && 
-            sortedHorizontalLines[i].effectiveLineWidth[0] == sortedHorizontalLines[i-1].effectiveLineWidth[0] &&
-            sortedHorizontalLines[i].effectiveLineWidth[1] == sortedHorizontalLines[i-1].effectiveLineWidth[1] &&
-            sortedHorizontalLines[i].globalPointOne[0] >= sortedHorizontalLines[i-1].globalPointOne[0] &&
-            sortedHorizontalLines[i].globalPointTwo[0] >= sortedHorizontalLines[i-1].globalPointTwo[0] &&
-            sortedHorizontalLines[i].globalPointTwo[0] + sortedHorizontalLines[i].effectiveLineWidth[0] >= sortedHorizontalLines[i-1].globalPointOne[0] - INTERSECT_THRESHOLD
-        ) {
-            // if y of both this and earlier line is the same and x's are close (less or equal to width diff) and line widths are the same then it's probably intended
-            // that those are 2 segments of the same line. merge them.
-            sortedHorizontalLines[i-1].globalPointTwo[0] = sortedHorizontalLines[i].globalPointTwo[0];
-            sortedHorizontalLines.erase(sortedHorizontalLines.begin() + i);
-            continue;
-        }   
-
-        // if y of later line + its width is higher than y of earlier line, check if their x's intersect. Then this pretty surely means that this is not actually
-        // a table line, but rather some overlay drawing. ignore the new line
-        if(
-            sortedHorizontalLines[i].globalPointOne[1] + sortedHorizontalLines[i].effectiveLineWidth[1] >= sortedHorizontalLines[i-1].globalPointOne[1] &&
-            sortedHorizontalLines[i-1].globalPointTwo[0] >= sortedHorizontalLines[i].globalPointOne[0] &&
-            sortedHorizontalLines[i].globalPointTwo[0] >= sortedHorizontalLines[i-1].globalPointOne[0]
-        ) {
-            sortedHorizontalLines.erase(sortedHorizontalLines.begin() + i);
-            continue;
-        }
+struct LineHash {
+    size_t operator()(const ParsedLinePlacement* inLine) const {
+        hash<double> hashDouble;
+        size_t result = 0;
+        const double values[6] = {
+            inLine->globalPointOne[0], inLine->globalPointOne[1],
+            inLine->globalPointTwo[0], inLine->globalPointTwo[1],
+            inLine->effectiveLineWidth[0], inLine->effectiveLineWidth[1]
+        };
+        for(size_t i=0;i<6;++i)
+            result ^= hashDouble(NormalizeZero(values[i])) + 0x9e3779b9 + (result << 6) + (result >> 2);
+        return result;
     }
-    ParsedLinePlacementVector sortedVerticalLines(inLines.verticalLines.begin(), inLines.verticalLines.end());
-    sort(sortedVerticalLines.begin(), sortedVerticalLines.end(), CompareVerticalLines);
+};
 
-    for(size_t i=sortedVerticalLines.size()-1;i>0;--i) {
-        if(
-            sortedVerticalLines[i].globalPointOne[0] == sortedVerticalLines[i-1].globalPointOne[0] && 
-            sortedVerticalLines[i].effectiveLineWidth[0] == sortedVerticalLines[i-1].effectiveLineWidth[0] &&
-            sortedVerticalLines[i].effectiveLineWidth[1] == sortedVerticalLines[i-1].effectiveLineWidth[1] &&
-            sortedVerticalLines[i].globalPointOne[1] <= sortedVerticalLines[i-1].globalPointOne[1] &&
-            sortedVerticalLines[i].globalPointTwo[1] <= sortedVerticalLines[i-1].globalPointTwo[1] &&
-            sortedVerticalLines[i].globalPointOne[1] + sortedVerticalLines[i].effectiveLineWidth[1] >= sortedVerticalLines[i-1].globalPointTwo[1] - INTERSECT_THRESHOLD
-        ) {
-            // if x of both this and earlier line is the same and y's are close (less or equal to width diff) and line widths are the same then it's probably intended
-            // that those are 2 segments of the same line. merge them.
-            sortedVerticalLines[i-1].globalPointTwo[1] = sortedVerticalLines[i].globalPointTwo[1];
-            sortedVerticalLines.erase(sortedVerticalLines.begin() + i);
-            continue;
-        }
+struct LineEqual {
+    bool operator()(const ParsedLinePlacement* inA, const ParsedLinePlacement* inB) const {
+        return AreLinesEqual(*inA, *inB);
+    }
+};
+
+typedef unordered_set<const ParsedLinePlacement*, LineHash, LineEqual> ParsedLinePlacementPtrSet;
+
+void CopyDistinctLines(const ParsedLinePlacementList& inLines, ParsedLinePlacementVector& outLines) {
+    // drop exact duplicates (same line drawn a few times, e.g. for fake bold) before sorting and merging. they would
+    // be merged into their twin anyways, but this keeps the sort and merge passes small. lines with NaN coordinates never equal
+    // anything, so they are all kept
+    ParsedLinePlacementPtrSet seenLines;
+    seenLines.reserve(inLines.size());
+    outLines.reserve(inLines.size());
+
+    ParsedLinePlacementList::const_iterator it = inLines.begin();
+    for(; it != inLines.end(); ++it) {
+        if(seenLines.insert(&(*it)).second)
+            outLines.push_back(*it);
+    }
+}
+
+bool IsHorizontalLineContinuation(const ParsedLinePlacement& inLine, const ParsedLinePlacement& inPreviousLine) {
+    // if y of both this and earlier line is the same and x's are close (less or equal to width diff) and line widths are the same then it's probably intended
+    // that those are 2 segments of the same line.
+    return inLine.globalPointOne[1] == inPreviousLine.globalPointOne[1] && 
+        inLine.effectiveLineWidth[0] == inPreviousLine.effectiveLineWidth[0] &&
+        inLine.effectiveLineWidth[1] == inPreviousLine.effectiveLineWidth[1] &&
+        inLine.globalPointOne[0] >= inPreviousLine.globalPointOne[0] &&
+        inLine.globalPointTwo[0] >= inPreviousLine.globalPointTwo[0] &&
+        inLine.globalPointTwo[0] + inLine.effectiveLineWidth[0] >= inPreviousLine.globalPointOne[0] - INTERSECT_THRESHOLD;
+}
+
+bool IsHorizontalLineOverlay(const ParsedLinePlacement& inLine, const ParsedLinePlacement& inPreviousLine) {
+    // if y of later line + its width is higher than y of earlier line, check if their x's intersect. Then this pretty surely means that this is not actually
+    // a table line, but rather some overlay drawing.
+    return inLine.globalPointOne[1] + inLine.effectiveLineWidth[1] >= inPreviousLine.globalPointOne[1] &&
+        inPreviousLine.globalPointTwo[0] >= inLine.globalPointOne[0] &&
+        inLine.globalPointTwo[0] >= inPreviousLine.globalPointOne[0];
+}
+
+bool IsVerticalLineContinuation(const ParsedLinePlacement& inLine, const ParsedLinePlacement& inPreviousLine) {
+    // if x of both this and earlier line is the same and y's are close (less or equal to width diff) and line widths are the same then it's probably intended
+    // that those are 2 segments of the same line.
+    return inLine.globalPointOne[0] == inPreviousLine.globalPointOne[0] && 
+        inLine.effectiveLineWidth[0] == inPreviousLine.effectiveLineWidth[0] &&
+        inLine.effectiveLineWidth[1] == inPreviousLine.effectiveLineWidth[1] &&
+        inLine.globalPointOne[1] <= inPreviousLine.globalPointOne[1] &&
+        inLine.globalPointTwo[1] <= inPreviousLine.globalPointTwo[1] &&
+        inLine.globalPointOne[1] + inLine.effectiveLineWidth[1] >= inPreviousLine.globalPointTwo[1] - INTERSECT_THRESHOLD;
+}
+
+bool IsVerticalLineOverlay(const ParsedLinePlacement& inLine, const ParsedLinePlacement& inPreviousLine) {
+    // if x of later line - its width is leftier than x of earlier line, check if their y's intersect. Then this pretty surely means that this is not actually
+    // a table line, but rather some overlay drawing.
+    return inLine.globalPointOne[0] - inLine.effectiveLineWidth[0] <= inPreviousLine.globalPointOne[0] &&
+        inPreviousLine.globalPointOne[1] >= inLine.globalPointTwo[1] &&
+        inLine.globalPointOne[1] >= inPreviousLine.globalPointTwo[1];
+}
+
+typedef bool (*LinesPairTest)(const ParsedLinePlacement& inLine, const ParsedLinePlacement& inPreviousLine);
 
-        if(
-            sortedVerticalLines[i].globalPointOne[0] - sortedVerticalLines[i].effectiveLineWidth[0] <= sortedVerticalLines[i-1].globalPointOne[0] &&
-            sortedVerticalLines[i-1].globalPointOne[1] >= sortedVerticalLines[i].globalPointTwo[1] &&
-            sortedVerticalLines[i].globalPointOne[1] >= sortedVerticalLines[i-1].globalPointTwo[1]
-        ) {
-            // if x of later line - its width is leftier than x of earlier line, check if their y's intersect. Then this pretty surely means that this is not actually
-            // a table line, but rather some overlay drawing. ignore the new line
-            sortedVerticalLines.erase(sortedVerticalLines.begin() + i);
+void CompactSortedLines(
+    ParsedLinePlacementVector& refSortedLines,
+    LinesPairTest inIsContinuation,
+    LinesPairTest inIsOverlay,
+    size_t inLengthAxis
+) {
+    // walk from the end, comparing each line with the one before it. a continuation is merged into the earlier line (extending
+    // its end), and an overlay is dropped. kept lines are packed towards the end of the vector, and the leftover head is erased once.
+    if(refSortedLines.size() < 2)
+        return;
+
+    size_t writeIndex = refSortedLines.size();
+    size_t current = refSortedLines.size() - 1;
+    for(; current > 0; --current) {
+        ParsedLinePlacement& previousLine = refSortedLines[current - 1];
+        if(inIsContinuation(refSortedLines[current], previousLine)) {
+            previousLine.globalPointTwo[inLengthAxis] = refSortedLines[current].globalPointTwo[inLengthAxis];
             continue;
         }
+        if(inIsOverlay(refSortedLines[current], previousLine))
+            continue;
+
+        --writeIndex;
+        if(writeIndex != current)
+            refSortedLines[writeIndex] = refSortedLines[current];
     }
+    --writeIndex;
+    if(writeIndex != 0)
+        refSortedLines[writeIndex] = refSortedLines[0];
+
+    refSortedLines.erase(refSortedLines.begin(), refSortedLines.begin() + writeIndex);
+}
+
+Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], bool inShouldParseInternalTables) {
+    Table result;
+
+    ParsedLinePlacementVector sortedHorizontalLines;
+    CopyDistinctLines(inLines.horizontalLines, sortedHorizontalLines);
+    sort(sortedHorizontalLines.begin(), sortedHorizontalLines.end(), CompareHorizontalLines);
+    CompactSortedLines(sortedHorizontalLines, IsHorizontalLineContinuation, IsHorizontalLineOverlay, 0);
+
+    ParsedLinePlacementVector sortedVerticalLines;
+    CopyDistinctLines(inLines.verticalLines, sortedVerticalLines);
+    sort(sortedVerticalLines.begin(), sortedVerticalLines.end(), CompareVerticalLines);
+    CompactSortedLines(sortedVerticalLines, IsVerticalLineContinuation, IsVerticalLineOverlay, 1);
 
     ParsedLinePlacement leftVertical = sortedVerticalLines.front();
     ParsedLinePlacement rightVertical = sortedVerticalLines.back();
@@ -478,14 +683,12 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
         ParsedLinePlacement currentLeft = *itCell;
         ++itCell;
         for(; itCell != cellLines.end(); ++itCell) {
-            CellInRow cellInRow(
+            // texts and internal table will be computed later
+            cells.push_back(CellInRow(
                 currentLeft,
                 *itCell,
-                1, // initial value, computation below
-                ParsedTextPlacementList(), // will be computed later
-                NULL // will be computed later
-            );
-            cells.push_back(cellInRow);
+                1 // initial value, computation below
+            ));
             currentLeft = *itCell;
         }
 
@@ -493,9 +696,9 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
         Row row = {
             currentTop,
             *it,
-            cells
+            move(cells)
         };
-        result.rows.push_back(row);
+        result.rows.push_back(move(row));
 
         currentTop = *it;
     }
@@ -525,9 +728,10 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
 
     if(inShouldParseInternalTables) {
         // Compute internal tables for each row cell. internal tables represent split cells where there are any.
-        // I can consider making this more efficient by computing the internal lines earlier....
-        // This computation is not very efficient iterating all table lines for each cell...i guess it's not a big deal
-        // but there's room to improve here when i do want to
+        // the table lines are indexed once, so that finding each cell lines doesn't go through all of them
+        TableLinesIndex linesIndex;
+        BuildTableLinesIndex(sortedHorizontalLines, sortedVerticalLines, linesIndex);
+
         RowVector::iterator itRows = result.rows.begin();
         for(; itRows != result.rows.end(); ++itRows) {
             CellInRowVector::iterator itCells = itRows->cells.begin();
@@ -539,7 +743,7 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
                     itCells->rightLine.globalPointOne[0] + itCells->rightLine.effectiveLineWidth[0]/2,
                     itRows->topLine.globalPointOne[1] + itRows->topLine.effectiveLineWidth[1]/2,
                 };
-                Lines linesInBox = ComputeCellInternalLines(sortedHorizontalLines, sortedVerticalLines, cellBox);
+                Lines linesInBox = ComputeCellInternalLines(sortedHorizontalLines, sortedVerticalLines, linesIndex, cellBox);
                 
                 if(linesInBox.horizontalLines.size() <= 2 && linesInBox.verticalLines.size() <= 2 ) {
                     // k no internal lines...just the 4 lines (or somehow...not even thems) of the cell
@@ -563,7 +767,7 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
                     Result<Table> tableResult = CreateTable(*it, cellBox, inShouldParseInternalTables);
                     if(tableResult.IsOK() && AreLinesEqual(tableResult.GetValue().rows.front().topLine, itRows->topLine)) {
                         // got internal table! if it is indeed an internal table it should have the cell lines as boundaries...so just check one
-                        itCells->internalTable = new Table(tableResult.GetValue());
+                        itCells->internalTable.reset(new Table(move(tableResult.GetValue())));
                     }
                 }            
             }
@@ -571,14 +775,16 @@ Result<Table> CreateTable(const Lines& inLines, const double (&inScopeBox)[4], b
     }
 
 
-    return Result<Table>(result);
+    return Result<Table>(move(result));
 }
 
-bool AttachTextToContainerTableCell(const ParsedTextPlacement& inText, Table& refTable) {
+bool AttachTextToContainerTableCell(const ParsedTextPlacementList& inTextPlacements, size_t inTextIndex, Table& refTable) {
+    const PackedTextPlacement& text = inTextPlacements.GetPlacement(inTextIndex);
+
     // check if in horizontal range
-    if(refTable.rows.front().topLine.globalPointOne[1] < inText.globalBbox[1])
+    if(refTable.rows.front().topLine.globalPointOne[1] < text.globalBbox[1])
         return false;
-    if(refTable.rows.back().bottomLine.globalPointTwo[1] > inText.globalBbox[3])
+    if(refTable.rows.back().bottomLine.globalPointTwo[1] > text.globalBbox[3])
         return false;
     
 
@@ -589,7 +795,7 @@ bool AttachTextToContainerTableCell(const ParsedTextPlacement& inText, Table& re
     while(end - start > 1) {
         int candidateIndex = start + floor((end - start)/2.0);
 
-        if(refTable.rows[candidateIndex].topLine.globalPointOne[1] < inText.globalBbox[1]) {
+        if(refTable.rows[candidateIndex].topLine.globalPointOne[1] < text.globalBbox[1]) {
             end = candidateIndex;
         } else {
             start = candidateIndex;
@@ -599,9 +805,9 @@ bool AttachTextToContainerTableCell(const ParsedTextPlacement& inText, Table& re
     // start should have the row index now
     Row& textRow = refTable.rows[start];
     
-    if(textRow.cells.front().leftLine.globalPointOne[0] > inText.globalBbox[2])
+    if(textRow.cells.front().leftLine.globalPointOne[0] > text.globalBbox[2])
         return false;
-    if(textRow.cells.back().rightLine.globalPointTwo[0] < inText.globalBbox[0])
+    if(textRow.cells.back().rightLine.globalPointTwo[0] < text.globalBbox[0])
         return false;    
 
     // find cells
@@ -611,7 +817,7 @@ bool AttachTextToContainerTableCell(const ParsedTextPlacement& inText, Table& re
     while(end - start > 1) {
         int candidateIndex = start + floor((end - start)/2.0);
 
-        if(textRow.cells[candidateIndex].leftLine.globalPointTwo[0] > inText.globalBbox[2]) {
+        if(textRow.cells[candidateIndex].leftLine.globalPointTwo[0] > text.globalBbox[2]) {
             end = candidateIndex;
         } else {
             start = candidateIndex;
@@ -619,18 +825,164 @@ bool AttachTextToContainerTableCell(const ParsedTextPlacement& inText, Table& re
     }
 
     // start should have the cell index now
-    textRow.cells[start].textPlacements.push_back(inText);
+    textRow.cells[start].textPlacementIndexes.push_back(inTextIndex);
 
     // cell got internal table? attempt to attach to it too (no need to report back)
     if(textRow.cells[start].internalTable)
-        AttachTextToContainerTableCell(inText,*textRow.cells[start].internalTable);
+        AttachTextToContainerTableCell(inTextPlacements, inTextIndex, *textRow.cells[start].internalTable);
 
     return true;
 
 }
 
+typedef vector<SizeTVector> SizeTVectorVector;
+typedef vector<Table*> TablePtrVector;
+typedef pair<double, size_t> DoubleAndSizeT;
+typedef vector<DoubleAndSizeT> DoubleAndSizeTVector;
+
+struct TextCell {
+    size_t tableIndex;
+    size_t rowIndex;
+    size_t cellIndex;
+};
+
+typedef vector<TextCell> TextCellVector;
+
+static const size_t scNoTable = (size_t)-1;
+
+double TextBottomSortKey(const PackedTextPlacement& inText) {
+    // NaN goes last, which like in the row search of AttachTextToContainerTableCell gets it the last row
+    return isnan(inText.globalBbox[1]) ? -HUGE_VAL : inText.globalBbox[1];
+}
+
+size_t FindTextCell(const Row& inRow, double inTextRight) {
+    // binary search like AttachTextToContainerTableCell does
+    int start = 0;
+    int end = inRow.cells.size();
+
+    while(end - start > 1) {
+        int candidateIndex = start + floor((end - start)/2.0);
+
+        if(inRow.cells[candidateIndex].leftLine.globalPointTwo[0] > inTextRight) {
+            end = candidateIndex;
+        } else {
+            start = candidateIndex;
+        }
+    }
+    return start;
+}
+
+void FindTextsCellsInTable(
+    const ParsedTextPlacementList& inTextPlacements,
+    const SizeTVector& inSortedTexts,
+    size_t inTableIndex,
+    const Table& inTable,
+    TextCellVector& refTextCells
+) {
+    // same checks as AttachTextToContainerTableCell, for all of the table candidate texts at once. texts come sorted top to bottom,
+    // so instead of searching for each text row, the row only moves forward as texts go down
+    size_t rowIndex = 0;
+    SizeTVector::const_iterator it = inSortedTexts.begin();
+    for(; it != inSortedTexts.end(); ++it) {
+        if(refTextCells[*it].tableIndex != scNoTable)
+            continue; // an earlier table took it
+
+        const PackedTextPlacement& text = inTextPlacements.GetPlacement(*it);
+
+        // check if in horizontal range
+        if(inTable.rows.front().topLine.globalPointOne[1] < text.globalBbox[1])
+            continue;
+        if(inTable.rows.back().bottomLine.globalPointTwo[1] > text.globalBbox[3])
+            continue;
+
+        // the text row is the last one with a top that's not lower than the text bottom
+        while(rowIndex + 1 < inTable.rows.size() && !(inTable.rows[rowIndex + 1].topLine.globalPointOne[1] < text.globalBbox[1]))
+            ++rowIndex;
+
+        const Row& textRow = inTable.rows[rowIndex];
+        if(textRow.cells.size() == 0)
+            continue;
+        if(textRow.cells.front().leftLine.globalPointOne[0] > text.globalBbox[2])
+            continue;
+        if(textRow.cells.back().rightLine.globalPointTwo[0] < text.globalBbox[0])
+            continue;
+
+        refTextCells[*it].tableIndex = inTableIndex;
+        refTextCells[*it].rowIndex = rowIndex;
+        refTextCells[*it].cellIndex = FindTextCell(textRow, text.globalBbox[2]);
+    }
+}
+
+void ExpandBoxToLine(const ParsedLinePlacement& inLine, double (&refBox)[4]) {
+    double lineBox[4] = {
+        min(inLine.globalPointOne[0], inLine.globalPointTwo[0]) - inLine.effectiveLineWidth[0],
+        min(inLine.globalPointOne[1], inLine.globalPointTwo[1]) - inLine.effectiveLineWidth[1],
+        max(inLine.globalPointOne[0], inLine.globalPointTwo[0]) + inLine.effectiveLineWidth[0],
+        max(inLine.globalPointOne[1], inLine.globalPointTwo[1]) + inLine.effectiveLineWidth[1]
+    };
+    for(int i=0;i<4;++i) {
+        if(isnan(lineBox[i])) {
+            // can't tell where this line is, so can't rule out anything
+            refBox[0] = refBox[1] = -HUGE_VAL;
+            refBox[2] = refBox[3] = HUGE_VAL;
+            return;
+        }
+    }
+    for(int i=0;i<2;++i) {
+        if(lineBox[i] < refBox[i])
+            refBox[i] = lineBox[i];
+        if(lineBox[i+2] > refBox[i+2])
+            refBox[i+2] = lineBox[i+2];
+    }
+}
+
+void TableComposer::FindTableCandidatesBoxes(const Lines& inLines, const double (&inScopeBox)[4], TableCandidateBoxVector& outBoxes) {
+    outBoxes.clear();
+
+    // tables are made of the lines of these groups, so their boxes cover the tables boxes. the threshold makes up for
+    // texts coordinates precision, so texts on the edge are not ruled out
+    LinesList tablesLinesList = DetermineTablesLines(inLines, inScopeBox);
+    LinesList::iterator it = tablesLinesList.begin();
+    for(; it != tablesLinesList.end(); ++it) {
+        TableCandidateBox candidate;
+        candidate.box[0] = candidate.box[1] = HUGE_VAL;
+        candidate.box[2] = candidate.box[3] = -HUGE_VAL;
+
+        ParsedLinePlacementList::const_iterator itLines = it->horizontalLines.begin();
+        for(; itLines != it->horizontalLines.end(); ++itLines)
+            ExpandBoxToLine(*itLines, candidate.box);
+        itLines = it->verticalLines.begin();
+        for(; itLines != it->verticalLines.end(); ++itLines)
+            ExpandBoxToLine(*itLines, candidate.box);
+
+        candidate.box[0] -= INTERSECT_THRESHOLD;
+        candidate.box[1] -= INTERSECT_THRESHOLD;
+        candidate.box[2] += INTERSECT_THRESHOLD;
+        candidate.box[3] += INTERSECT_THRESHOLD;
+        outBoxes.push_back(candidate);
+    }
+}
+
+void SetTableTextPlacements(Table& refTable, const shared_ptr<const ParsedTextPlacementList>& inTextPlacements) {
+    refTable.textPlacements = inTextPlacements;
+
+    RowVector::iterator itRows = refTable.rows.begin();
+    for(; itRows != refTable.rows.end(); ++itRows) {
+        CellInRowVector::iterator itCells = itRows->cells.begin();
+        for(; itCells != itRows->cells.end(); ++itCells) {
+            if(itCells->internalTable)
+                SetTableTextPlacements(*itCells->internalTable, inTextPlacements);
+        }
+    }
+}
+
 TableList TableComposer::ComposeTables(const Lines& inLines, const ParsedTextPlacementList& inTextPlacements, const double (&inScopeBox)[4]) {
+    return ComposeTables(inLines, make_shared<const ParsedTextPlacementList>(inTextPlacements), inScopeBox);
+}
+
+TableList TableComposer::ComposeTables(const Lines& inLines, const shared_ptr<const ParsedTextPlacementList>& inTextPlacementsPtr, const double (&inScopeBox)[4]) {
     TableList tables; 
+    const ParsedTextPlacementList& inTextPlacements = *inTextPlacementsPtr;
 
     // in each page
     
@@ -641,19 +993,76 @@ TableList TableComposer::ComposeTables(const Lines& inLines, const ParsedTextPla
     LinesList::iterator it = tablesLinesList.begin();
     for(; it != tablesLinesList.end(); ++it) {
         Result<Table> tableResult = CreateTable(*it, inScopeBox, shouldParseInternalTables);
-        if(tableResult.IsOK())
-            tables.push_back(tableResult.GetValue());
+        if(tableResult.IsOK()) {
+            tables.push_back(move(tableResult.GetValue()));
+            SetTableTextPlacements(tables.back(), inTextPlacementsPtr);
+        }
     }
 
-    // now for each text find the right table for it - if any - and place it in the right cell
-    ParsedTextPlacementList::const_iterator itText = inTextPlacements.begin();
-    for(; itText != inTextPlacements.end(); ++itText) {
-        TableList::iterator itTables = tables.begin(); 
-        for(; itTables != tables.end(); ++itTables) {
-            if(AttachTextToContainerTableCell(*itText, *itTables))
-                break; // found the right cell...can stop the search now
-        }
+    // now for each text find the right table for it - if any - and place it in the right cell.
+    // only tables that the text box intersects may take it, so first find candidate tables per text with an index of table boxes.
+    // then have each table go through its candidate texts top to bottom, sweeping its rows
+    if(tables.size() == 0)
+        return tables;
+
+    TableBoxIndex tablesIndex(tables);
+
+    // list candidate tables per text. texts that are out of all tables go no further
+    SizeTVector candidateTexts;
+    SizeTVector candidateTablesOffsets;
+    SizeTVector candidateTables;
+    SizeTVector textTables;
+    for(size_t i=0; i < inTextPlacements.GetSize(); ++i) {
+        const PackedTextPlacement& text = inTextPlacements.GetPlacement(i);
+        double textBox[4] = {text.globalBbox[0], text.globalBbox[1], text.globalBbox[2], text.globalBbox[3]};
+        tablesIndex.FindTables(textBox, textTables);
+        if(textTables.size() == 0)
+            continue;
+
+        candidateTexts.push_back(i);
+        candidateTablesOffsets.push_back(candidateTables.size());
+        candidateTables.insert(candidateTables.end(), textTables.begin(), textTables.end());
+    }
+    candidateTablesOffsets.push_back(candidateTables.size());
+
+    // sort candidates top to bottom, and distribute them to their tables, so that each table gets its texts sorted.
+    // sorting on negated bottoms, keeping the candidate position to break ties
+    DoubleAndSizeTVector sortedCandidates(candidateTexts.size());
+    for(size_t i=0; i < sortedCandidates.size(); ++i)
+        sortedCandidates[i] = DoubleAndSizeT(-TextBottomSortKey(inTextPlacements.GetPlacement(candidateTexts[i])), i);
+    sort(sortedCandidates.begin(), sortedCandidates.end());
+
+    SizeTVectorVector tablesTexts(tables.size());
+    DoubleAndSizeTVector::iterator itSorted = sortedCandidates.begin();
+    for(; itSorted != sortedCandidates.end(); ++itSorted) {
+        size_t candidate = itSorted->second;
+        for(size_t j=candidateTablesOffsets[candidate]; j < candidateTablesOffsets[candidate + 1]; ++j)
+            tablesTexts[candidateTables[j]].push_back(candidateTexts[candidate]);
+    }
+
+    // a text goes to the first table that takes it, so go through tables in order
+    TablePtrVector tablesPtrs;
+    TextCell noCell = {scNoTable, 0, 0};
+    TextCellVector textCells(inTextPlacements.GetSize(), noCell);
+    TableList::iterator itTables = tables.begin();
+    for(; itTables != tables.end(); ++itTables) {
+        FindTextsCellsInTable(inTextPlacements, tablesTexts[tablesPtrs.size()], tablesPtrs.size(), *itTables, textCells);
+        tablesPtrs.push_back(&(*itTables));
+    }
+
+    // place texts in their cells, in the texts order
+    SizeTVector::iterator itCandidates = candidateTexts.begin();
+    for(; itCandidates != candidateTexts.end(); ++itCandidates) {
+        const TextCell& textCell = textCells[*itCandidates];
+        if(textCell.tableIndex == scNoTable)
+            continue;
+
+        CellInRow& cell = tablesPtrs[textCell.tableIndex]->rows[textCell.rowIndex].cells[textCell.cellIndex];
+        cell.textPlacementIndexes.push_back(*itCandidates);
 
+        // cell got internal table? attempt to attach to it too (no need to report back)
+        if(cell.internalTable)
+            AttachTextToContainerTableCell(inTextPlacements, *itCandidates, *cell.internalTable);
     }
 
     return tables;
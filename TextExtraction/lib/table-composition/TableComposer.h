@@ -5,11 +5,40 @@
 
 #include "../text-parsing/ParsedTextPlacement.h"
 
+#include <memory>
+#include <vector>
+
+struct TableCandidateBox {
+    double box[4];
+};
+
+typedef std::vector<TableCandidateBox> TableCandidateBoxVector;
+
+// groups of lines that connect (transitively intersect), with enough lines to form cells (more than one of each direction).
+// groups are in the order of their first line, and lines keep the input order within them
+LinesList DetermineTablesLines(const Lines& inLines, const double (&inScopeBox)[4]);
+
+// the intersection tests DetermineTablesLines connects lines by. lines are as TableLineInterpreter parses them - horizontal lines
+// left to right, and vertical lines top to bottom
+bool HorizontalIntersectsWithVertical(const ParsedLinePlacement& inHorizontalLine, const ParsedLinePlacement& inVerticalLine, const double (&inScopeBox)[4]);
+bool HorizontalIntersectsWithHorizontal(const ParsedLinePlacement& inHorizontalLine1, const ParsedLinePlacement& inHorizontalLine2, const double (&inScopeBox)[4]);
+bool VerticalIntersectsWithVertical(const ParsedLinePlacement& inVerticalLine1, const ParsedLinePlacement& inVerticalLine2, const double (&inScopeBox)[4]);
+
 class TableComposer {
     public:
         TableComposer();
         virtual ~TableComposer();
 
+        // parse split cells into internal tables of the cells. defaults to the SHOULD_PARSE_INTERNAL_TABLES compile flag
+        void SetShouldParseInternalTables(bool inShouldParseInternalTables);
+
+        // boxes of the groups of lines that may form tables, before checking whether they do. a page without any has no tables, and
+        // a text that doesn't intersect any of them can't be in a table. cheap to compute, as it doesn't need the page texts
+        void FindTableCandidatesBoxes(const Lines& inLines, const double (&inScopeBox)[4], TableCandidateBoxVector& outBoxes);
+
+        // tables cells refer to the page texts by index, and the tables share the page texts
+        TableList ComposeTables(const Lines& inLines, const std::shared_ptr<const ParsedTextPlacementList>& inTextPlacements, const double (&inScopeBox)[4]);
+        // same, sharing a copy of the page texts
         TableList ComposeTables(const Lines& inLines, const ParsedTextPlacementList& inTextPlacements, const double (&inScopeBox)[4]);
 
     private:
@@ -1,62 +1,85 @@
 #include "TableCSVExport.h"
-#include <string>
+#include "../output/OStreamOutputSink.h"
+
+#include <string.h>
 
 using namespace std;
 
-static const string scEmpty = "";
-static const string scDoubleQuote = "\"";
 static const char scDoubleQuoteChar = '\"';
-static const string scComma = ",";
+static const char scCommaChar = ',';
 static const string scCRLN = "\r\n";
 
-TableCSVExport::TableCSVExport(int inBidiFlag, TextComposer::ESpacing inSpacingFlag):textComposer(inBidiFlag, inSpacingFlag) {
+// cells are normally short, so a small buffer will do. longer cells just flush more often to cellText
+static const size_t scCellBufferSize = 4*1024;
 
+TableCSVExport::TableCSVExport(int inBidiFlag, TextComposer::ESpacing inSpacingFlag):
+    textComposer(inBidiFlag, inSpacingFlag),
+    cellSink(cellText),
+    cellBuffer(&cellSink, scCellBufferSize)
+{
+    bidiFlag = inBidiFlag;
 }
 
 TableCSVExport::~TableCSVExport() {
 
 }
 
-void TableCSVExport::Quote(const string& inString, std::ostream& outStream) {
-    if(inString.length() == 0) {
+void TableCSVExport::Quote(string_view inText, OutputBuffer& outBuffer) {
+    if(inText.length() == 0) {
         // don't quote if there's nothing and no need to introduce anything into the stream
         return;
     }
 
-    outStream<<scDoubleQuote;
-    string::const_iterator it = inString.begin();
-    for(; it != inString.end();++it) {
-        if(*it == scDoubleQuoteChar)
-            outStream<<scDoubleQuote<<scDoubleQuote;
-        else
-            outStream<<*it;
+    // write the text in runs between quotes, doubling each quote
+    outBuffer.Append(scDoubleQuoteChar);
+    const char* runStart = inText.data();
+    const char* textEnd = runStart + inText.length();
+    const char* quote;
+    while((quote = (const char*)memchr(runStart, scDoubleQuoteChar, textEnd - runStart)) != NULL) {
+        outBuffer.Append(runStart, quote - runStart + 1);
+        outBuffer.Append(scDoubleQuoteChar);
+        runStart = quote + 1;
     }
-    outStream<<scDoubleQuote;
+    outBuffer.Append(runStart, textEnd - runStart);
+    outBuffer.Append(scDoubleQuoteChar);
 }
 
-string TableCSVExport::GetCellText(const CellInRow& inCell) {
-    std::stringstream cellStream;
-    textComposer.ComposeText(inCell.textPlacements, cellStream);
-    return cellStream.str();
+void TableCSVExport::WriteCell(const Table& inTable, const CellInRow& inCell, OutputBuffer& outBuffer) {
+    if(!inTable.textPlacements || inCell.textPlacementIndexes.empty())
+        return;
+
+    // a single placement is a single line with nothing to sort or space, so its text is the cell text as is
+    if(inCell.textPlacementIndexes.size() == 1 && bidiFlag == -1) {
+        Quote(inTable.textPlacements->GetText(inCell.textPlacementIndexes[0]), outBuffer);
+        return;
+    }
+
+    cellText.clear();
+    textComposer.ComposeText(*inTable.textPlacements, inCell.textPlacementIndexes, cellBuffer);
+    cellBuffer.Flush();
+    Quote(cellText, outBuffer);
 }
 
 void TableCSVExport::ComposeTableText(const Table& inTable, std::ostream& outStream) {
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
+
+    ComposeTableText(inTable, buffer);
+}
+
+void TableCSVExport::ComposeTableText(const Table& inTable, OutputBuffer& outBuffer) {
     RowVector::const_iterator itRows = inTable.rows.begin();
 
     for(; itRows != inTable.rows.end(); ++itRows) {
         CellInRowVector::const_iterator itCols = itRows->cells.begin();
-        Quote(GetCellText(*itCols), outStream);
+        WriteCell(inTable, *itCols, outBuffer);
         ++itCols;
         for(; itCols != itRows->cells.end(); ++itCols) {
-            outStream<<scComma;
-            Quote(GetCellText(*itCols), outStream);
-            for(int i = 1; i < itCols->colSpan;++i)
-                outStream<<scComma;
+            outBuffer.Append(scCommaChar);
+            WriteCell(inTable, *itCols, outBuffer);
+            if(itCols->colSpan > 1)
+                outBuffer.AppendRepeated(scCommaChar, itCols->colSpan - 1);
         }
-        outStream<<scCRLN;
+        outBuffer.Append(scCRLN);
     }
 }
-
-
-
-
@@ -2,7 +2,11 @@
 
 #include "../text-composition/TextComposer.h"
 #include "../table-composition/Table.h"
+#include "../output/OutputBuffer.h"
+#include "../output/StringOutputSink.h"
 #include <ostream>
+#include <string>
+#include <string_view>
 
 class TableCSVExport {
     public:
@@ -11,11 +15,19 @@ class TableCSVExport {
 
 
         void ComposeTableText(const Table& inTable, std::ostream& outStream);
+        // write to an output buffer. it is not flushed, so call Flush on it when done
+        void ComposeTableText(const Table& inTable, OutputBuffer& outBuffer);
 
     private:
+        int bidiFlag;
         TextComposer textComposer;
 
-        std::string GetCellText(const CellInRow& inCell);
-        void Quote(const std::string& inString, std::ostream& outStream);
+        // cells are composed here before they are quoted. reused between cells
+        std::string cellText;
+        StringOutputSink cellSink;
+        OutputBuffer cellBuffer;
 
-};
\ No newline at end of file
+        void WriteCell(const Table& inTable, const CellInRow& inCell, OutputBuffer& outBuffer);
+        void Quote(std::string_view inText, OutputBuffer& outBuffer);
+
+};
@@ -0,0 +1,95 @@
+#include "ParallelPageComposer.h"
+
+#include "../output/CallbackOutputSink.h"
+
+#include <thread>
+
+using namespace std;
+
+// pages composed ahead of the writer, per worker
+static const size_t scPagesAheadPerWorker = 4;
+static const size_t scPageBufferSize = 16*1024;
+
+ParallelPageComposer::ParallelPageComposer(unsigned int inWorkersCount) {
+    workersCount = inWorkersCount;
+    composePage = NULL;
+    pagesCount = 0;
+    windowSize = 0;
+    nextPageIndex = 0;
+    writtenPagesCount = 0;
+}
+
+unsigned int ParallelPageComposer::GetWorkersCount(size_t inPagesCount) const {
+    if(workersCount < 2 || inPagesCount < 2)
+        return 1;
+    return workersCount < inPagesCount ? workersCount : (unsigned int)inPagesCount;
+}
+
+void ParallelPageComposer::Compose(size_t inPagesCount, const ComposePageFunction& inComposePage, OutputBuffer& outBuffer) {
+    unsigned int threadsCount = GetWorkersCount(inPagesCount);
+    if(threadsCount == 1) {
+        for(size_t i=0;i<inPagesCount;++i)
+            inComposePage(i, 0, outBuffer);
+        return;
+    }
+
+    composePage = &inComposePage;
+    pagesCount = inPagesCount;
+    windowSize = threadsCount * scPagesAheadPerWorker;
+    pages.assign(inPagesCount, ComposedPage());
+    nextPageIndex = 0;
+    writtenPagesCount = 0;
+
+    vector<thread> workers;
+    for(unsigned int i=0;i<threadsCount;++i)
+        workers.push_back(thread(&ParallelPageComposer::RunWorker, this, (size_t)i));
+
+    // write pages in order, as they become ready
+    for(size_t i=0;i<inPagesCount;++i) {
+        string pageText;
+        {
+            unique_lock<mutex> lock(pagesMutex);
+            pageDone.wait(lock, [this, i]{return pages[i].isDone;});
+            pageText.swap(pages[i].text);
+            writtenPagesCount = i + 1;
+        }
+        pageWritten.notify_all();
+        outBuffer.Append(pageText);
+    }
+
+    for(size_t i=0;i<workers.size();++i)
+        workers[i].join();
+
+    pages.clear();
+    composePage = NULL;
+}
+
+void ParallelPageComposer::RunWorker(size_t inWorkerIndex) {
+    string pageText;
+    CallbackOutputSink sink([&pageText](const char* inData, size_t inLength) {
+        pageText.append(inData, inLength);
+        return true;
+    });
+    OutputBuffer pageBuffer(&sink, scPageBufferSize);
+
+    size_t pageIndex = nextPageIndex++;
+    while(pageIndex < pagesCount) {
+        {
+            // don't get too far ahead of the writer
+            unique_lock<mutex> lock(pagesMutex);
+            pageWritten.wait(lock, [this, pageIndex]{return pageIndex < writtenPagesCount + windowSize;});
+        }
+
+        (*composePage)(pageIndex, inWorkerIndex, pageBuffer);
+        pageBuffer.Flush();
+
+        {
+            lock_guard<mutex> lock(pagesMutex);
+            pages[pageIndex].text.swap(pageText);
+            pages[pageIndex].isDone = true;
+        }
+        pageDone.notify_all();
+        pageText.clear();
+        pageIndex = nextPageIndex++;
+    }
+}
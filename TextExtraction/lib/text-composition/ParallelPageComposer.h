@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../output/OutputBuffer.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/**
+ * Composes pages on a pool of worker threads, writing the results in page order.
+ * Each worker composes whole pages into its own page buffer. Finished pages wait in a reorder buffer till all pages before them
+ * are written, so the output is the same as composing the pages one after the other.
+ * Workers run at most a window of pages ahead of the writer, so memory is bound by that window and not by the document size.
+ *
+ * The compose function is called from the worker threads, along with the worker index, so callers can keep per worker
+ * composition state (like a TextComposer) in a vector indexed by it. With less than 2 workers, or a single page, pages
+ * are composed on the calling thread straight into the output buffer.
+ */
+class ParallelPageComposer {
+    public:
+        typedef std::function<void(size_t inPageIndex, size_t inWorkerIndex, OutputBuffer& outBuffer)> ComposePageFunction;
+
+        ParallelPageComposer(unsigned int inWorkersCount);
+
+        // number of workers Compose will actually use for this many pages
+        unsigned int GetWorkersCount(size_t inPagesCount) const;
+
+        void Compose(size_t inPagesCount, const ComposePageFunction& inComposePage, OutputBuffer& outBuffer);
+
+    private:
+        struct ComposedPage {
+            ComposedPage() {
+                isDone = false;
+            }
+
+            std::string text;
+            bool isDone;
+        };
+        typedef std::vector<ComposedPage> ComposedPageVector;
+
+        unsigned int workersCount;
+
+        // per compose run state
+        const ComposePageFunction* composePage;
+        size_t pagesCount;
+        size_t windowSize;
+        ComposedPageVector pages;
+        std::atomic<size_t> nextPageIndex;
+        size_t writtenPagesCount;
+        std::mutex pagesMutex;
+        std::condition_variable pageDone;
+        std::condition_variable pageWritten;
+
+        void RunWorker(size_t inWorkerIndex);
+};
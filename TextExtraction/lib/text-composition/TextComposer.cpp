@@ -1,7 +1,7 @@
 #include "TextComposer.h"
 
 
-#include "../bidi/BidiConversion.h"
+#include "../output/OStreamOutputSink.h"
 
 #include <algorithm>
 #include <vector>
@@ -9,10 +9,10 @@
 
 using namespace std;
 
-static const string scEmpty = "";
 static const char scSpace = ' ';
 
-void UnionLeftBoxToRight(const double (&inLeftBox)[4], double (&refRightBox)[4]) {
+template <typename T>
+void UnionLeftBoxToRight(const T (&inLeftBox)[4], double (&refRightBox)[4]) {
     // union left box to right box resulting in a box that contains both
     
     if(inLeftBox[0] < refRightBox[0])
@@ -29,7 +29,8 @@ double BoxHeight(const double (&inBox)[4]) {
     return inBox[3] - inBox[1];
 }
 
-double BoxWidth(const double (&inBox)[4]) {
+template <typename T>
+double BoxWidth(const T (&inBox)[4]) {
     return inBox[2] - inBox[0];
 }
 
@@ -53,7 +54,13 @@ TextComposer::~TextComposer() {
 
 const double LINE_HEIGHT_THRESHOLD = 5;
 
-int GetOrientationCode(const ParsedTextPlacement& a) {
+template <typename T>
+void CopyPlacementBox(const T (&inBox)[4], double (&refBox)[4]) {
+    for(int i=0;i<4;++i)
+        refBox[i] = inBox[i];
+}
+
+int GetOrientationCode(const PackedTextPlacement& a) {
     // a very symplistic heuristics to try and logically group different text orientations in a way that makes sense
 
     // 1 0 0 1
@@ -72,63 +79,56 @@ int GetOrientationCode(const ParsedTextPlacement& a) {
     return 3;
 }
 
-bool CompareForOrientation(const ParsedTextPlacement& a, const ParsedTextPlacement& b, int code) {
-    if(code == 0) {
-        if(abs(a.globalBbox[1] - b.globalBbox[1]) > LINE_HEIGHT_THRESHOLD)
-            return b.globalBbox[1] < a.globalBbox[1];
-        else
-            return a.globalBbox[0] < b.globalBbox[0];    
-
-    } else if(code == 1) {
-        if(abs(a.globalBbox[0] - b.globalBbox[0]) > LINE_HEIGHT_THRESHOLD)
-            return a.globalBbox[0] <  b.globalBbox[0];
-        else
-            return a.globalBbox[1] < b.globalBbox[1];    
-
-    } else if(code == 2) {
-        if(abs(a.globalBbox[1] - b.globalBbox[1]) > LINE_HEIGHT_THRESHOLD)
-            return a.globalBbox[1] < b.globalBbox[1];
-        else
-            return b.globalBbox[0] < a.globalBbox[0];    
-           
+// sort keys of a placement, computed once per placement. per orientation, lineKey is the coordinate across lines, and positionKey the coordinate
+// along the line, both set so that ascending order is reading order
+struct PlacementSortKey {
+    int orientation;
+    double lineKey;
+    double positionKey;
+    size_t index;
+};
+
+typedef std::vector<PlacementSortKey> PlacementSortKeyVector;
+
+void ComputePlacementSortKey(const PackedTextPlacement& inPlacement, size_t inIndex, PlacementSortKey& refKey) {
+    refKey.index = inIndex;
+    refKey.orientation = GetOrientationCode(inPlacement);
+
+    if(refKey.orientation == 0) {
+        // top to bottom, left to right
+        refKey.lineKey = -inPlacement.globalBbox[1];
+        refKey.positionKey = inPlacement.globalBbox[0];
+    } else if(refKey.orientation == 1) {
+        // left to right, bottom to top
+        refKey.lineKey = inPlacement.globalBbox[0];
+        refKey.positionKey = inPlacement.globalBbox[1];
+    } else if(refKey.orientation == 2) {
+        // bottom to top, right to left
+        refKey.lineKey = inPlacement.globalBbox[1];
+        refKey.positionKey = -inPlacement.globalBbox[0];
     } else {
-        // code 3
-        if(abs(a.globalBbox[0] - b.globalBbox[0]) > LINE_HEIGHT_THRESHOLD)
-            return b.globalBbox[0] < a.globalBbox[0];
-        else
-            return b.globalBbox[1] < a.globalBbox[1];    
+        // right to left, top to bottom
+        refKey.lineKey = -inPlacement.globalBbox[0];
+        refKey.positionKey = -inPlacement.globalBbox[1];
     }
-    
 }
 
-bool CompareParsedTextPlacement(const ParsedTextPlacement& a, const ParsedTextPlacement& b) {
-    int codeA = GetOrientationCode(a);
-    int codeB = GetOrientationCode(b);
-
-    if(codeA == codeB) {
-        return CompareForOrientation(a,b,codeA);
-    }
-    
-    return codeA < codeB;
+// orders by orientation and then line key. the placement index breaks ties, so the order is total and the results deterministic
+bool CompareLineKeys(const PlacementSortKey& a, const PlacementSortKey& b) {
+    if(a.orientation != b.orientation)
+        return a.orientation < b.orientation;
+    if(a.lineKey != b.lineKey)
+        return a.lineKey < b.lineKey;
+    return a.index < b.index;
 }
 
-typedef std::vector<ParsedTextPlacement> ParsedTextPlacementVector;
-
-bool AreSameLine(const ParsedTextPlacement& a, const ParsedTextPlacement& b) {
-    int codeA = GetOrientationCode(a);
-    int codeB = GetOrientationCode(b);
-
-    if(codeA != codeB)
-        return false;
-
-    if(codeA == 0 || codeA == 2) {
-        return abs(a.globalBbox[1] - b.globalBbox[1]) <= LINE_HEIGHT_THRESHOLD;
-    } else {
-        return abs(a.globalBbox[0] - b.globalBbox[0]) <= LINE_HEIGHT_THRESHOLD;
-    }
+bool ComparePositionKeys(const PlacementSortKey& a, const PlacementSortKey& b) {
+    if(a.positionKey != b.positionKey)
+        return a.positionKey < b.positionKey;
+    return a.index < b.index;
 }
 
-unsigned long GuessHorizontalSpacingBetweenPlacements(const ParsedTextPlacement& left, const ParsedTextPlacement& right) {
+unsigned long GuessHorizontalSpacingBetweenPlacements(const PackedTextPlacement& left, const PackedTextPlacement& right) {
     double leftTextRightEdge = left.globalBbox[2];
     double rightTextLeftEdge = right.globalBbox[0];
 
@@ -141,7 +141,7 @@ unsigned long GuessHorizontalSpacingBetweenPlacements(const ParsedTextPlacement&
     if(spaceWidth == 0 && BoxWidth(left.globalBbox) > 0) {
         // if no available space width from font info, try to evaluate per the left string width/char length...not the best...but
         // easy.
-        spaceWidth = BoxWidth(left.globalBbox) / left.text.length();
+        spaceWidth = BoxWidth(left.globalBbox) / left.textLength;
     }
 
     if(spaceWidth == 0)
@@ -152,76 +152,115 @@ unsigned long GuessHorizontalSpacingBetweenPlacements(const ParsedTextPlacement&
 
 static const string scCRLN = "\r\n";
 
-void TextComposer::MergeLineStreamToResultString(
-    const stringstream& inStream, 
+void TextComposer::MergeLineToResult(
+    const string& inLine, 
     int bidiFlag,
     bool shouldAddSpacesPerLines, 
     const double (&inLineBox)[4],
     const double (&inPrevLineBox)[4],
-    std::ostream& outStream
+    OutputBuffer& outBuffer
 ) {
-    BidiConversion bidi;
-
     // add spaces before line, per distance from last line (verify that we have non zero height to avoid infinite loops)
     if(shouldAddSpacesPerLines && BoxTop(inLineBox) < BoxBottom(inPrevLineBox) && BoxHeight(inPrevLineBox) > 0) {
         unsigned long verticalLines = floor((BoxBottom(inPrevLineBox) - BoxTop(inLineBox))/BoxHeight(inPrevLineBox));
         for(unsigned long i=0;i<verticalLines;++i)
-            outStream<<scCRLN;
+            outBuffer.Append(scCRLN);
     }
 
 
     if(bidiFlag == -1) {
-        outStream<<inStream.str();
+        outBuffer.Append(inLine);
     }
     else {
-        string bidiResult;
-        bidi.ConvertVisualToLogical(inStream.str(), bidiFlag, bidiResult); // returning status may be used to convey that's succeeded
-        outStream<<bidiResult;
+        bidi.ConvertVisualToLogical(inLine, bidiFlag, bidiResult); // returning status may be used to convey that's succeeded
+        outBuffer.Append(bidiResult);
     }
 }
 
 void TextComposer::ComposeText(const ParsedTextPlacementList& inTextPlacements, std::ostream& outStream) {
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
+
+    ComposeText(inTextPlacements, buffer);
+}
+
+void TextComposer::ComposeText(const ParsedTextPlacementList& inTextPlacements, OutputBuffer& outBuffer) {
+    if(inTextPlacements.IsEmpty())
+        return;
+
+    // compute placements keys once, and sort the keys (rather than the placements) to lines order
+    PlacementSortKeyVector keys(inTextPlacements.GetSize());
+    for(size_t i=0;i<keys.size();++i)
+        ComputePlacementSortKey(inTextPlacements.GetPlacement(i), i, keys[i]);
+
+    ComposeKeys(inTextPlacements, keys, outBuffer);
+}
+
+void TextComposer::ComposeText(const ParsedTextPlacementList& inTextPlacements, const vector<size_t>& inIndexes, ostream& outStream) {
+    OStreamOutputSink sink(outStream);
+    OutputBuffer buffer(&sink, OStreamOutputSink::scBufferSize);
+
+    ComposeText(inTextPlacements, inIndexes, buffer);
+}
+
+void TextComposer::ComposeText(const ParsedTextPlacementList& inTextPlacements, const vector<size_t>& inIndexes, OutputBuffer& outBuffer) {
+    if(inIndexes.empty())
+        return;
+
+    // keys hold the placements indexes in the whole list. as these break ties, the result is the same as composing a list
+    // with just these placements (in the same order)
+    PlacementSortKeyVector keys(inIndexes.size());
+    for(size_t i=0;i<keys.size();++i)
+        ComputePlacementSortKey(inTextPlacements.GetPlacement(inIndexes[i]), inIndexes[i], keys[i]);
+
+    ComposeKeys(inTextPlacements, keys, outBuffer);
+}
+
+void TextComposer::ComposeKeys(const ParsedTextPlacementList& inTextPlacements, PlacementSortKeyVector& refKeys, OutputBuffer& outBuffer) {
     double lineBox[4];
     double prevLineBox[4];
-    bool isFirstLine;
     bool addVerticalSpaces = spacingFlag & TextComposer::eSpacingVertical;
     bool addHorizontalSpaces = spacingFlag & TextComposer::eSpacingHorizontal;
 
-    ParsedTextPlacementVector sortedTextCommands(inTextPlacements.begin(), inTextPlacements.end());
-    sort(sortedTextCommands.begin(), sortedTextCommands.end(), CompareParsedTextPlacement);
-
-    ParsedTextPlacementVector::iterator itCommands = sortedTextCommands.begin();
-    if(itCommands == sortedTextCommands.end())
-        return;
+    sort(refKeys.begin(), refKeys.end(), CompareLineKeys);
 
-    // k. got some text, let's build it
-    stringstream lineResult;
-    ParsedTextPlacement& latestItem = *itCommands;
+    // sweep the sorted keys to lines. a line starts with its first placement and takes the following placements of the same orientation
+    // that are within LINE_HEIGHT_THRESHOLD from it. then the line placements are sorted along the line, and the line is written
     bool hasPreviousLineInPage = false;
-    CopyBox(itCommands->globalBbox, lineBox);
-    lineResult<<latestItem.text;
-    ++itCommands;
-    for(; itCommands != sortedTextCommands.end();++itCommands) {
-        if(AreSameLine(latestItem, *itCommands)) {
+    size_t lineStart = 0;
+    while(lineStart < refKeys.size()) {
+        size_t lineEnd = lineStart + 1;
+        while(lineEnd < refKeys.size() &&
+                refKeys[lineEnd].orientation == refKeys[lineStart].orientation &&
+                refKeys[lineEnd].lineKey - refKeys[lineStart].lineKey <= LINE_HEIGHT_THRESHOLD)
+            ++lineEnd;
+        sort(refKeys.begin() + lineStart, refKeys.begin() + lineEnd, ComparePositionKeys);
+
+        if(hasPreviousLineInPage)
+            outBuffer.Append(scCRLN);
+
+        // k. got some text, let's build the line. the line buffer is reused between lines
+        const PackedTextPlacement* latestItem = &inTextPlacements.GetPlacement(refKeys[lineStart].index);
+        CopyPlacementBox(latestItem->globalBbox, lineBox);
+        lineBuffer.assign(inTextPlacements.GetText(refKeys[lineStart].index));
+        for(size_t i = lineStart + 1; i < lineEnd; ++i) {
+            const PackedTextPlacement& item = inTextPlacements.GetPlacement(refKeys[i].index);
             if(addHorizontalSpaces) {
-                unsigned long spaces = GuessHorizontalSpacingBetweenPlacements(latestItem, *itCommands);
+                unsigned long spaces = GuessHorizontalSpacingBetweenPlacements(*latestItem, item);
                 if(spaces != 0)
-                    lineResult<<string(spaces, scSpace);
+                    lineBuffer.append(spaces, scSpace);
             }
-            UnionLeftBoxToRight(itCommands->globalBbox, lineBox);
-        } else {
-            // merge complete line to accumulated text, and start a fresh line with fresh accumulators
-            MergeLineStreamToResultString(lineResult, bidiFlag ,addVerticalSpaces && hasPreviousLineInPage, lineBox, prevLineBox, outStream);
-            outStream<<scCRLN;
-            lineResult.str(scEmpty);
-            CopyBox(lineBox, prevLineBox);
-            CopyBox(itCommands->globalBbox, lineBox);
-            hasPreviousLineInPage = true;
+            UnionLeftBoxToRight(item.globalBbox, lineBox);
+            lineBuffer.append(inTextPlacements.GetText(refKeys[i].index));
+            latestItem = &item;
         }
-        lineResult<<itCommands->text;
-        latestItem = *itCommands;
-    }
-    MergeLineStreamToResultString(lineResult, bidiFlag ,addVerticalSpaces && hasPreviousLineInPage, lineBox, prevLineBox, outStream);
 
+        // merge complete line to accumulated text
+        MergeLineToResult(lineBuffer, bidiFlag ,addVerticalSpaces && hasPreviousLineInPage, lineBox, prevLineBox, outBuffer);
+        CopyBox(lineBox, prevLineBox);
+        hasPreviousLineInPage = true;
+
+        lineStart = lineEnd;
+    }
 }
 
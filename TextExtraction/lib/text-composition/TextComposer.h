@@ -1,12 +1,16 @@
 #pragma once
 
 #include "../text-parsing/ParsedTextPlacement.h"
+#include "../output/OutputBuffer.h"
+#include "../bidi/BidiConversion.h"
 
 #include <string>
 #include <list>
-#include <sstream>
+#include <vector>
 #include <ostream>
 
+struct PlacementSortKey;
+
 class TextComposer {
     public:
 
@@ -22,19 +26,32 @@ class TextComposer {
         virtual ~TextComposer();
 
 
+        void ComposeText(const ParsedTextPlacementList& inTextPlacements, OutputBuffer& outBuffer);
         void ComposeText(const ParsedTextPlacementList& inTextPlacements, std::ostream& outStream);
+        // compose just the placements at inIndexes (ascending), like a list with only these placements would
+        void ComposeText(const ParsedTextPlacementList& inTextPlacements, const std::vector<size_t>& inIndexes, OutputBuffer& outBuffer);
+        void ComposeText(const ParsedTextPlacementList& inTextPlacements, const std::vector<size_t>& inIndexes, std::ostream& outStream);
 
     private:
         int bidiFlag;
         ESpacing spacingFlag;
 
-    void MergeLineStreamToResultString(
-        const std::stringstream& inStream, 
+        // line buffers, reused between lines
+        std::string lineBuffer;
+        std::string bidiResult;
+
+        // one conversion object for all lines, it holds on to ICU state and buffers
+        BidiConversion bidi;
+
+    void ComposeKeys(const ParsedTextPlacementList& inTextPlacements, std::vector<PlacementSortKey>& refKeys, OutputBuffer& outBuffer);
+
+    void MergeLineToResult(
+        const std::string& inLine, 
         int bidiFlag,
         bool shouldAddSpacesPerLines, 
         const double (&inLineBox)[4],
         const double (&inPrevLineBox)[4],
-        std::ostream& outStream
+        OutputBuffer& outBuffer
     );
 
 
@@ -6,4 +6,8 @@ class ITextInterpreterHandler {
 
 public:
     virtual bool OnParsedTextPlacementComplete(const ParsedTextPlacement& inParsedTextPlacement) = 0; 
+
+    // called with the global box of a text placement before its text is decoded. return false to skip the placement, which
+    // then won't be reported
+    virtual bool ShouldDecodeTextPlacement(const double (&inGlobalBbox)[4]) {return true;}
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "ParsedTextPlacement.h"
+
+using namespace std;
+
+ParsedTextPlacementList::ParsedTextPlacementList() {
+
+}
+
+void ParsedTextPlacementList::Add(const ParsedTextPlacement& inPlacement) {
+    PackedTextPlacement placement;
+
+    AddText(inPlacement.text.data(), inPlacement.text.length(), placement);
+    placement.fontID = inPlacement.fontID;
+    for(int i=0;i<4;++i)
+        placement.globalBbox[i] = (PlacementCoordinate)inPlacement.globalBbox[i];
+    for(int i=0;i<2;++i)
+        placement.globalSpaceWidth[i] = (PlacementCoordinate)inPlacement.globalSpaceWidth[i];
+    for(int i=0;i<4;++i)
+        placement.matrix[i] = (PlacementCoordinate)inPlacement.matrix[i];
+
+    placements.push_back(placement);
+}
+
+void ParsedTextPlacementList::Add(const ParsedTextPlacementList& inOther, size_t inIndex) {
+    PackedTextPlacement placement = inOther.placements[inIndex];
+
+    AddText(inOther.texts.data() + placement.textOffset, placement.textLength, placement);
+    placements.push_back(placement);
+}
+
+void ParsedTextPlacementList::AddText(const char* inText, size_t inLength, PackedTextPlacement& refPlacement) {
+    refPlacement.textOffset = (uint32_t)texts.length();
+    refPlacement.textLength = (uint32_t)inLength;
+    texts.append(inText, inLength);
+}
+
+void ParsedTextPlacementList::Reserve(size_t inPlacementsCount, size_t inTextLength) {
+    placements.reserve(inPlacementsCount);
+    texts.reserve(inTextLength);
+}
+
+void ParsedTextPlacementList::Clear() {
+    placements.clear();
+    texts.clear();
+}
+
+size_t ParsedTextPlacementList::GetSize() const {
+    return placements.size();
+}
+
+bool ParsedTextPlacementList::IsEmpty() const {
+    return placements.empty();
+}
+
+const PackedTextPlacement& ParsedTextPlacementList::GetPlacement(size_t inIndex) const {
+    return placements[inIndex];
+}
+
+string_view ParsedTextPlacementList::GetText(size_t inIndex) const {
+    const PackedTextPlacement& placement = placements[inIndex];
+    return string_view(texts.data() + placement.textOffset, placement.textLength);
+}
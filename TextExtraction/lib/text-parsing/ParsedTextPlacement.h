@@ -4,7 +4,9 @@
 #include "ObjectsBasicTypes.h"
 
 #include <string>
-#include <list>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
 
 struct ParsedTextPlacement {
     ParsedTextPlacement(
@@ -35,4 +37,54 @@ struct ParsedTextPlacement {
 };
 
 
-typedef std::list<ParsedTextPlacement> ParsedTextPlacementList;
+// stored placement coordinates. doubles by default, floats when built with COMPACT_PLACEMENT_COORDINATES,
+// which halves the placement record size at the price of precision (about 7 significant digits, so fine for page coordinates).
+#ifdef COMPACT_PLACEMENT_COORDINATES
+typedef float PlacementCoordinate;
+#else
+typedef double PlacementCoordinate;
+#endif
+
+/**
+ * PackedTextPlacement is how placements are stored, once parsed. It only keeps what composition and users of the results need.
+ * text is kept by the containing list, in a single buffer per list, and the record has its offset and length.
+ * matrix is the 2x2 part of the placement matrix (sans translation), which is good for orientation.
+ */
+struct PackedTextPlacement {
+    uint32_t textOffset;
+    uint32_t textLength;
+    ObjectIDType fontID;
+    PlacementCoordinate globalBbox[4];
+    PlacementCoordinate globalSpaceWidth[2];
+    PlacementCoordinate matrix[4];
+};
+
+typedef std::vector<PackedTextPlacement> PackedTextPlacementVector;
+
+/**
+ * ParsedTextPlacementList holds the placements of a page (or of a table cell), packed.
+ * placements are in a vector, and their texts are all in one string.
+ */
+class ParsedTextPlacementList {
+    public:
+        ParsedTextPlacementList();
+
+        void Add(const ParsedTextPlacement& inPlacement);
+        // copy placement inIndex of another list
+        void Add(const ParsedTextPlacementList& inOther, size_t inIndex);
+
+        void Reserve(size_t inPlacementsCount, size_t inTextLength);
+        void Clear();
+
+        size_t GetSize() const;
+        bool IsEmpty() const;
+        const PackedTextPlacement& GetPlacement(size_t inIndex) const;
+        // text view is valid as long as the list is not changed
+        std::string_view GetText(size_t inIndex) const;
+
+    private:
+        PackedTextPlacementVector placements;
+        std::string texts;
+
+        void AddText(const char* inText, size_t inLength, PackedTextPlacement& refPlacement);
+};
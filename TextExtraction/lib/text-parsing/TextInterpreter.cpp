@@ -23,11 +23,15 @@ static const ObjectIDType EMBEDDED_FONT_ID_START = 0x80000000UL;
 
 TextInterpeter::TextInterpeter(void) {
     SetHandler(NULL);
+    SetFontDecoderPrefetcher(NULL);
+    SetMemoryResource(NULL);
     nextEmbeddedFontID = EMBEDDED_FONT_ID_START;
 }
 
 TextInterpeter::TextInterpeter(ITextInterpreterHandler* inHandler) {
     SetHandler(inHandler);
+    SetFontDecoderPrefetcher(NULL);
+    SetMemoryResource(NULL);
     nextEmbeddedFontID = EMBEDDED_FONT_ID_START;
 }
 
@@ -137,12 +141,8 @@ bool TextInterpeter::OnTextElementComplete(const TextElement& inTextElement) {
                 double minPlacement = 0;
                 double maxPlacement = 0;
 
-                // Translate the text and accumulate
-                FontDecoderResult result = decoder->Translate(argumentIt->bytes);
-
-
                 // Compute the text dimensions and position/matrix
-                DispositionResultList dispositions = decoder->ComputeDisplacements(argumentIt->bytes);
+                DispositionResultList dispositions = decoder->ComputeDisplacements(argumentIt->bytes, memoryResource);
                 DispositionResultList::iterator itDispositions = dispositions.begin();
                 for(; itDispositions != dispositions.end(); ++itDispositions) {
                     double displacement = itDispositions->width;
@@ -170,6 +170,15 @@ bool TextInterpeter::OnTextElementComplete(const TextElement& inTextElement) {
                 MultiplyMatrix(itemTextStateTm,item.graphicState.ctm, matrixBuffer);
                 TransformBox(localBBox, matrixBuffer, globalBBox);
 
+                // the position is known. check with the handler before translating the text, which is the expensive part
+                if(!handler->ShouldDecodeTextPlacement(globalBBox)) {
+                    CopyMatrix(nextPlacementDefaultTm, itemTextStateTm);
+                    continue;
+                }
+
+                // Translate the text
+                FontDecoderResult result = decoder->Translate(argumentIt->bytes);
+
                 TransformVector(widthVector, matrixBuffer, transformedWidthVector);
                 TransformVector(zeroVector, matrixBuffer, transformedZeroVector);
                 globalWidthVector[0] = abs(transformedWidthVector[0] - transformedZeroVector[0]);
@@ -229,6 +238,16 @@ bool TextInterpeter::OnResourcesRead(const Resources& inResources, IInterpreterC
             ObjectIDType id = ((PDFIndirectObjectReference*)(it->second.fontRef.GetPtr()))->mObjectID;
             ObjectIDTypeToFontDecoderMap::const_iterator itFont = refrencedFontDecoders.find(id);
             if(itFont == refrencedFontDecoders.end()) {
+                // prefer a decoder that was already built ahead of time, if there is one
+                unique_ptr<FontDecoder> prefetchedDecoder(prefetcher ? prefetcher->TakeDecoder(id) : unique_ptr<FontDecoder>());
+                if(!!prefetchedDecoder) {
+                    refrencedFontDecoders.insert(ObjectIDTypeToFontDecoderMap::value_type(
+                        id,
+                        move(*prefetchedDecoder)
+                    ));
+                    continue;
+                }
+
                 PDFObjectCastPtr<PDFDictionary> fontDict = inContext->GetParser()->ParseNewObject(id);
                 if(!fontDict)
                     continue; // ignore
@@ -246,4 +265,12 @@ bool TextInterpeter::OnResourcesRead(const Resources& inResources, IInterpreterC
 
 void TextInterpeter::SetHandler(ITextInterpreterHandler* inHandler) {
     handler = inHandler;
+}
+
+void TextInterpeter::SetFontDecoderPrefetcher(FontDecoderPrefetcher* inPrefetcher) {
+    prefetcher = inPrefetcher;
+}
+
+void TextInterpeter::SetMemoryResource(pmr::memory_resource* inMemoryResource) {
+    memoryResource = inMemoryResource ? inMemoryResource : pmr::get_default_resource();
 }
\ No newline at end of file
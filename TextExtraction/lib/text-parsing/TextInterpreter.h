@@ -3,6 +3,7 @@
 #include "../graphic-content-parsing/TextElement.h"
 #include "../graphic-content-parsing/Resources.h"
 #include "../font-translation/FontDecoder.h"
+#include "../font-translation/FontDecoderPrefetcher.h"
 
 #include "ITextInterpreterHandler.h"
 
@@ -12,6 +13,7 @@
 class PDFObject;
 
 #include <map>
+#include <memory_resource>
 
 class IInterpreterContext;
 
@@ -33,6 +35,12 @@ class TextInterpeter {
 
         void SetHandler(ITextInterpreterHandler* inHandler);
 
+        // optional source for fonts decoders built ahead of time. fonts not provided by it are parsed when met
+        void SetFontDecoderPrefetcher(FontDecoderPrefetcher* inPrefetcher);
+
+        // memory resource for per text element temporaries. pass NULL to get back to the default resource
+        void SetMemoryResource(std::pmr::memory_resource* inMemoryResource);
+
         // forwarded by external party implementing IGraphicContentInterpreterHandler
         // with only what's relevant to text
         bool OnTextElementComplete(const TextElement& inTextElement);
@@ -44,6 +52,8 @@ class TextInterpeter {
         FontInfoMap GetFontInfoMap() const;
     private:
         ITextInterpreterHandler* handler;
+        FontDecoderPrefetcher* prefetcher;
+        std::pmr::memory_resource* memoryResource;
 
         // font decoders parsed data
         ObjectIDTypeToFontDecoderMap refrencedFontDecoders;
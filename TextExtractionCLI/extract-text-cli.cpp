@@ -1,6 +1,9 @@
 #include <iostream>
 #include <string>
-#include <fstream>
+#include <sstream>
+#include <memory>
+#include <functional>
+#include <stdlib.h>
 
 #include "EStatusCode.h"
 #include "BoxingBase.h"
@@ -9,6 +12,11 @@
 #include "TableExtraction.h"
 #include "TextPlacementReader.h"
 #include "lib/text-composition/TextComposer.h"
+#include "lib/output/OutputBuffer.h"
+#include "lib/output/FileDescriptorOutputSink.h"
+#include "lib/output/CallbackOutputSink.h"
+#include "lib/result-cache/ExtractionResultCache.h"
+#include "lib/result-cache/CachedExtraction.h"
 
 #include <nlohmann/json.hpp>
 
@@ -27,27 +35,151 @@ static void ShowUsage(const string& name)
 #endif
               << "\t-p, --spacing <BOTH|HOR|VER|NONE>\tadd spaces between pieces of text considering their relative positions. default is BOTH\n"
               << "\t-t, --tables\t\t\t\textract tables instead of text. Each table is represented in CSV\n"
+              << "\t-a, --text-and-tables\t\t\textract both text and tables in a single pass. text is written first, then tables CSV. with --output, text goes to the output file and tables to CSV files with an ordinal (starting from 1)\n"
+              << "\t-r, --table-text <ALL|PAGES|REGIONS>\twith --tables, decode text of ALL pages (default), or only of PAGES with table lines, or only in table REGIONS\n"
+              << "\t-f, --prefetch-fonts <d>\t\tparse the document fonts ahead of time with <d> worker threads\n"
+              << "\t-w, --compose-workers <d>\t\tcompose the text of pages on <d> worker threads\n"
+              << "\t-m, --memory-stats\t\t\tshow per page allocation counters of the page interpretation arena\n"
               << "\t-i, --iterator\t\t\t\tuse iterator API to output text placements with bounding boxes\n"
               << "\t-j, --json\t\t\t\twith --iterator, output as JSON (summary line + NDJSON placements)\n"
               << "\t-o, --output /path/to/file\t\twrite result to output file (or files for tables export)\n"
+              << "\t-c, --cache-dir /path/to/dir\t\tkeep results in a cache directory, and use them for the same PDF content and options. default is TEXT_EXTRACTION_CACHE_DIR environment variable, if set\n"
+              << "\t-n, --no-cache\t\t\t\tdon't use a cache directory\n"
               << "\t-q, --quiet\t\t\t\tquiet run. only shows errors and warnings\n"
               << "\t-h, --help\t\t\t\tShow this help message\n"
               << "\t-d, --debug /path/to/file\t\tcreate debug output file\n"
               << endl;
 }
 
+static void ShowPageArenaStats(const PageArenaStats& inStats)
+{
+    double pages = inStats.pagesCount > 0 ? inStats.pagesCount : 1;
+    cerr << "Pages: " << inStats.pagesCount << "\n"
+              << "Arena allocations: " << inStats.arenaAllocationsCount << " (" << inStats.arenaAllocationsCount / pages << " per page)\n"
+              << "Arena bytes: " << inStats.arenaAllocatedBytes << " (" << inStats.arenaAllocatedBytes / pages << " per page, max page " << inStats.maxPageAllocatedBytes << ")\n"
+              << "Arena heap allocations: " << inStats.heapAllocationsCount << " (" << inStats.heapAllocationsCount / pages << " per page)\n"
+              << endl;
+}
+
 static const string BIDI_LTR = "LTR";
 static const string BIDI_RTL = "RTL";
 static const string SPACING_BOTH = "BOTH";
 static const string SPACING_HOR = "HOR";
 static const string SPACING_VER = "VER";
 static const string SPACING_NONE = "NONE";
+static const string TABLE_TEXT_ALL = "ALL";
+static const string TABLE_TEXT_PAGES = "PAGES";
+static const string TABLE_TEXT_REGIONS = "REGIONS";
 
 static const string scCSVExtension = ".csv";
 static const string scDot = ".";
 
 static const unsigned char scUTF8Bom[3] = {0xEF,0xBB,0xBF};
 
+static const string scStandardOutput = "";
+static const char* scCacheDirectoryVariable = "TEXT_EXTRACTION_CACHE_DIR";
+
+typedef function<void(OutputBuffer&)> ComposeFunction;
+typedef function<void(size_t, OutputBuffer&)> ComposeTableFunction;
+
+// write a results part to a file (with a UTF8 BOM), or to the standard output when inFilePath is empty. inCompose writes the part
+static EStatusCode WriteResultsPart(const string& inFilePath, const ComposeFunction& inCompose)
+{
+    unique_ptr<FileDescriptorOutputSink> target;
+    if(inFilePath.empty()) {
+        // write straight to the standard output file descriptor, bypassing iostreams
+        cout.flush();
+        target.reset(new FileDescriptorOutputSink(1));
+    } else {
+        target.reset(new FileDescriptorOutputSink(inFilePath));
+        if(!target->IsOpen()) {
+            cerr << "Error: Cannot open target file path for writing in" << inFilePath.c_str() << endl;
+            return eFailure;
+        }
+        if(!target->Write((const char*)scUTF8Bom, 3)) {
+            cerr << "Error: Failed writing to " << inFilePath.c_str() << endl;
+            return eFailure;
+        }
+    }
+
+    CallbackOutputSink sink([&target](const char* inData, size_t inLength) {
+        return target->Write(inData, inLength);
+    });
+
+    EStatusCode status;
+    {
+        OutputBuffer outputBuffer(&sink);
+        inCompose(outputBuffer);
+        status = outputBuffer.Flush();
+    }
+
+    if(status != eSuccess && !inFilePath.empty())
+        cerr << "Error: Failed writing to " << inFilePath.c_str() << endl;
+    return status;
+}
+
+static EStatusCode WriteTextResults(bool inWriteToOutputFile, const string& inOutputFilePath, bool inReportToErrors,
+    const ComposeFunction& inCompose)
+{
+    EStatusCode status = WriteResultsPart(inWriteToOutputFile ? inOutputFilePath : scStandardOutput, inCompose);
+    if(status == eSuccess && inWriteToOutputFile)
+        (inReportToErrors ? cerr : cout) << "Wrote text to " << inOutputFilePath.c_str() << endl;
+    return status;
+}
+
+// the first table goes to the output file path with a CSV extension, and later tables to the same path with an ordinal (starting from 1).
+// with inShouldNumberAll the first table gets an ordinal too. with text, the text is at the output file path, which may well be the first
+// table file path (say, with an out.csv output)
+static string GetTableFilePath(const string& inOutputFilePath, size_t inTableIndex, bool inShouldNumberAll)
+{
+    size_t extensionPos = inOutputFilePath.find_last_of(scDot);
+    string baseOutputFilePath = inOutputFilePath.substr(0, extensionPos);
+    size_t ordinal = inShouldNumberAll ? inTableIndex + 1 : inTableIndex;
+    if(ordinal == 0)
+        return baseOutputFilePath + scCSVExtension;
+    return baseOutputFilePath + Int((int)ordinal).ToString() + scCSVExtension;
+}
+
+// to files, each table is written by inComposeTable to a CSV of its own. to the standard output, inComposeAll writes all tables
+static EStatusCode WriteTablesResults(bool inWriteToOutputFile, const string& inOutputFilePath, bool inShouldNumberAll, size_t inTablesCount,
+    const ComposeTableFunction& inComposeTable, const ComposeFunction& inComposeAll)
+{
+    if(!inWriteToOutputFile)
+        return WriteResultsPart(scStandardOutput, inComposeAll);
+
+    EStatusCode status = eSuccess;
+    for(size_t i = 0; i < inTablesCount && status == eSuccess; ++i) {
+        string tableFilePath = GetTableFilePath(inOutputFilePath, i, inShouldNumberAll);
+        status = WriteResultsPart(
+            tableFilePath,
+            [&inComposeTable, i](OutputBuffer& outBuffer) {
+                inComposeTable(i, outBuffer);
+            });
+        if(status == eSuccess)
+            cerr << "Wrote table to " << tableFilePath.c_str() << endl;
+    }
+    return status;
+}
+
+static void ShowWarnings(const ExtractionWarningList& inWarnings)
+{
+    ExtractionWarningList::const_iterator it = inWarnings.begin();
+    for(; it != inWarnings.end(); ++it) {
+        cerr << "Warning: " << it->description.c_str() << endl;
+    }
+}
+
+// open the cache directory. NULL if it can't be used, in which case extraction goes on without it
+static ExtractionResultCache* OpenResultsCache(const string& inCacheDirectoryPath)
+{
+    unique_ptr<ExtractionResultCache> cache(new ExtractionResultCache(inCacheDirectoryPath));
+    if(!cache->Open()) {
+        cerr << "Warning: Cannot use cache directory " << inCacheDirectoryPath.c_str() << endl;
+        return NULL;
+    }
+    return cache.release();
+}
+
 int main(int argc, char* argv[])
 {
     if(argc < 2) {
@@ -66,8 +198,16 @@ int main(int argc, char* argv[])
     bool quiet = false;
     long bidiFlag = -1;
     bool extractTables = false;
+    bool extractTextAndTables = false;
     bool useIteratorAPI = false;
     bool jsonOutput = false;
+    unsigned int fontPrefetchWorkers = 0;
+    unsigned int compositionWorkers = 0;
+    bool showMemoryStats = false;
+    TableExtraction::ETextDecoding tableTextDecoding = TableExtraction::eTextDecodingAllPages;
+    const char* cacheDirectoryVariable = getenv(scCacheDirectoryVariable);
+    string cacheDirectoryPath = cacheDirectoryVariable ? cacheDirectoryVariable : "";
+    bool useCache = true;
 
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -78,10 +218,40 @@ int main(int argc, char* argv[])
             quiet = true;
         } else if ((arg == "-t") || (arg == "--tables")) {
             extractTables = true;
+        } else if ((arg == "-a") || (arg == "--text-and-tables")) {
+            extractTables = true;
+            extractTextAndTables = true;
         } else if ((arg == "-i") || (arg == "--iterator")) {
             useIteratorAPI = true;
         } else if ((arg == "-j") || (arg == "--json")) {
             jsonOutput = true;
+        } else if ((arg == "-n") || (arg == "--no-cache")) {
+            useCache = false;
+        } else if ((arg == "-c") || (arg == "--cache-dir")) {
+            if (i + 1 < argc) {
+                cacheDirectoryPath = argv[++i];
+            } else {
+                std::cerr << "--cache-dir option requires one argument, which is the cache directory path." << std::endl;
+                return 1;
+            }
+        } else if ((arg == "-m") || (arg == "--memory-stats")) {
+            showMemoryStats = true;
+        } else if ((arg == "-f") || (arg == "--prefetch-fonts")) {
+            if (i + 1 < argc) {
+                long workersCount = Long(argv[++i]);
+                fontPrefetchWorkers = workersCount > 0 ? (unsigned int)workersCount : 0;
+            } else {
+                std::cerr << "--prefetch-fonts option requires one argument, which is the number of worker threads." << std::endl;
+                return 1;                 
+            }            
+        } else if ((arg == "-w") || (arg == "--compose-workers")) {
+            if (i + 1 < argc) {
+                long workersCount = Long(argv[++i]);
+                compositionWorkers = workersCount > 0 ? (unsigned int)workersCount : 0;
+            } else {
+                std::cerr << "--compose-workers option requires one argument, which is the number of worker threads." << std::endl;
+                return 1;
+            }
         } else if ((arg == "-s") || (arg == "--start")) {
             if (i + 1 < argc) {
                 startPage = Long(argv[++i]);
@@ -133,6 +303,23 @@ int main(int argc, char* argv[])
                 return 1;                 
             }            
 
+        } else if((arg == "-r") || (arg == "--table-text")) {
+            if (i + 1 < argc) {
+                string argString = argv[++i];
+                if(argString == TABLE_TEXT_ALL)
+                    tableTextDecoding = TableExtraction::eTextDecodingAllPages;
+                else if(argString == TABLE_TEXT_PAGES)
+                    tableTextDecoding = TableExtraction::eTextDecodingTablePages;
+                else if(argString == TABLE_TEXT_REGIONS)
+                    tableTextDecoding = TableExtraction::eTextDecodingTableRegions;
+                else {
+                    std::cerr << "--table-text option requires one argument, which is the text decoding policy. Use either ALL, PAGES (only pages with table lines) or REGIONS (only text in table lines regions)." << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "--table-text option requires one argument, which is the text decoding policy. Use either ALL, PAGES (only pages with table lines) or REGIONS (only text in table lines regions)." << std::endl;
+                return 1;
+            }
         } else if((arg == "-d") || (arg == "--debug")) {
             debugging = true;
             if (i + 1 < argc) {
@@ -156,6 +343,9 @@ int main(int argc, char* argv[])
         }
     }    
 
+    if(!useCache)
+        cacheDirectoryPath.clear();
+
     EStatusCode status = eSuccess;
     if(debugging) {
         TextExtraction textExtraction;
@@ -163,22 +353,24 @@ int main(int argc, char* argv[])
     } else if(useIteratorAPI) {
         // Demonstrate the new iterator-based TextPlacementReader API
         try {
-            TextPlacementReader pdf(filePath);
+            // with a cache, placements are mapped from a placements cache of the same content, if there is one
+            unique_ptr<ExtractionResultCache> cache;
+            if(!cacheDirectoryPath.empty())
+                cache.reset(OpenResultsCache(cacheDirectoryPath));
+
+            const TextPlacementReader pdf = cache ? TextPlacementReader::open_cached(*cache, filePath) : TextPlacementReader(filePath);
 
             if(!quiet) {
                 if(jsonOutput) {
-                    // JSON output mode: summary line + NDJSON placements
-                    // Use the built-in JSON methods from TextPlacementReader
-                    cout << pdf.summary_json().dump() << endl;
-
-                    // Iterate over placements (optionally filtered by page range)
-                    auto range = (startPage != 0 || endPage != -1)
-                        ? pdf.pages(startPage, endPage)
-                        : pdf.pages(0, -1);
-
-                    for (const auto& tp : range) {
-                        cout << tp.to_json().dump() << endl;
-                    }
+                    // JSON output mode: summary line + NDJSON placements (optionally filtered by page range),
+                    // written as they go straight to the standard output file descriptor
+                    cout.flush();
+                    FileDescriptorOutputSink standardOutput(1);
+                    OutputBuffer outputBuffer(&standardOutput);
+                    pdf.write_summary_json(outputBuffer);
+                    outputBuffer.Append('\n');
+                    pdf.write_placements_ndjson(outputBuffer, startPage, endPage);
+                    status = outputBuffer.Flush();
                 } else {
                     // Human-readable output
                     cout << "Pages: " << pdf.pageCount() << endl;
@@ -202,14 +394,16 @@ int main(int argc, char* argv[])
 
                     for (const auto& tp : range) {
                         // Format: page fontID [x, y, width, height] "text"
-                        printf("%lu %lu [%7.2f, %7.2f, %7.2f, %7.2f] %s\n",
+                        // text is a view into the reader storage, not null terminated
+                        printf("%lu %lu [%7.2f, %7.2f, %7.2f, %7.2f] %.*s\n",
                                tp.pageNumber,
                                tp.fontID,
                                tp.bbox[0],
                                tp.bbox[1],
                                tp.bbox[2],
                                tp.bbox[3],
-                               tp.text.c_str());
+                               static_cast<int>(tp.text.size()),
+                               tp.text.data());
                     }
                 }
             }
@@ -218,84 +412,115 @@ int main(int argc, char* argv[])
             status = eFailure;
         }
     } else {
-        if(extractTables) {
+        // with a cache, results of the same content and options are written from the cache instead of extracting them.
+        // quiet runs to the standard output don't write results, so there's nothing to cache
+        unique_ptr<ExtractionResultCache> cache;
+        if(!cacheDirectoryPath.empty() && (writeToOutputFile || !quiet))
+            cache.reset(OpenResultsCache(cacheDirectoryPath));
+        // text to the output file is reported on the standard output, unless with tables, where the standard output may have tables CSV
+        bool reportTextToErrors = extractTextAndTables;
+
+        if(cache) {
+            CachedExtraction cachedExtraction(cache.get());
+            cachedExtraction.SetPagesRange(startPage, endPage);
+            cachedExtraction.SetComposition(bidiFlag, spacing);
+            cachedExtraction.SetExtraction(!extractTables || extractTextAndTables, extractTables);
+            cachedExtraction.SetTableTextDecoding(tableTextDecoding);
+            cachedExtraction.SetFontPrefetchWorkers(fontPrefetchWorkers);
+            cachedExtraction.SetCompositionWorkers(compositionWorkers);
+
+            ExtractionResults results;
+            status = cachedExtraction.Extract(filePath, results);
+            if(showMemoryStats && cachedExtraction.GetLatestCacheUse() != CachedExtraction::eCacheUseHit)
+                ShowPageArenaStats(cachedExtraction.GetPageArenaStats());
+
+            if(status != eSuccess) {
+                cerr << "Error: " << cachedExtraction.LatestError.description.c_str() << endl;
+            }
+            ShowWarnings(results.warnings);
+            if(cachedExtraction.GetLatestCacheUse() == CachedExtraction::eCacheUseStoreFailed)
+                cerr << "Warning: Cannot write results to cache directory " << cacheDirectoryPath.c_str() << endl;
+
+            if(status == eSuccess && (!extractTables || extractTextAndTables)) {
+                status = WriteTextResults(writeToOutputFile, outputFilePath, reportTextToErrors,
+                    [&results](OutputBuffer& outBuffer) {
+                        outBuffer.Append(results.text);
+                    });
+            }
+            if(status == eSuccess && extractTables) {
+                status = WriteTablesResults(writeToOutputFile, outputFilePath, extractTextAndTables, results.tables.size(),
+                    [&results](size_t inTableIndex, OutputBuffer& outBuffer) {
+                        outBuffer.Append(results.tables[inTableIndex]);
+                    },
+                    [&results](OutputBuffer& outBuffer) {
+                        results.WriteAllTablesCSV(outBuffer);
+                    });
+            }
+        } else if(extractTables) {
             TableExtraction tableExtraction;
+            tableExtraction.SetFontPrefetchWorkers(fontPrefetchWorkers);
+            tableExtraction.SetCompositionWorkers(compositionWorkers);
+            // with text, all pages text is needed anyways
+            tableExtraction.SetTextDecoding(extractTextAndTables ? TableExtraction::eTextDecodingAllPages : tableTextDecoding);
+            tableExtraction.SetShouldKeepPageTexts(extractTextAndTables);
             status = tableExtraction.ExtractTables(filePath, startPage, endPage);
+            if(showMemoryStats)
+                ShowPageArenaStats(tableExtraction.GetPageArenaStats());
 
             if(status != eSuccess) {
                 cerr << "Error: " << tableExtraction.LatestError.description.c_str() << endl;
             }
-            ExtractionWarningList::iterator it = tableExtraction.LatestWarnings.begin();
-            for(; it != tableExtraction.LatestWarnings.end(); ++it) {
-                cerr << "Warning: " << it->description.c_str() << endl;
-            }    
+            ShowWarnings(tableExtraction.LatestWarnings);
 
-            if(status == eSuccess) {
-                if(writeToOutputFile) {
-                    size_t extensionPos = outputFilePath.find_last_of(scDot);
-                    string baseOutputFilePath = outputFilePath.substr(0, extensionPos);
-                    string filePath  = baseOutputFilePath;
-                    int ordinal = 0;
-                    
-                    // writing each table to a separate CSV
-                    TableListList::iterator itPages = tableExtraction.tablesForPages.begin();
-                    for(; itPages != tableExtraction.tablesForPages.end() && status == eSuccess; ++itPages) {
-                        TableList::iterator itTables = itPages->begin();
-                        for(; itTables != itPages->end() && status == eSuccess; ++itTables) {
-                            string fileFullPath = filePath + scCSVExtension;
-                            ofstream outputFile(fileFullPath, ios::binary);
-                            if (!outputFile.is_open()) {
-                                cerr << "Error: Cannot open target file path for writing in" << fileFullPath.c_str() << endl;
-                                status = eFailure;
-                            } else {
-                                outputFile.write((const char*)scUTF8Bom, 3);
-                                tableExtraction.GetTableAsCSVText(*itTables, bidiFlag, spacing, outputFile);
-                                outputFile.close();
-                                cerr << "Wrote table to " << fileFullPath.c_str() << endl;
-                            }
-                            ++ordinal;
-                            filePath = baseOutputFilePath + Int(ordinal).ToString();
-                        }
-                    }
-                } else if(!quiet) {
-                    tableExtraction.GetAllAsCSVText(bidiFlag, spacing, cout);
+            if(status == eSuccess && extractTextAndTables && (writeToOutputFile || !quiet)) {
+                // text first. when writing to files, the text goes to the output file, and tables to CSVs next to it
+                status = WriteTextResults(writeToOutputFile, outputFilePath, reportTextToErrors,
+                    [&tableExtraction, bidiFlag, spacing](OutputBuffer& outBuffer) {
+                        tableExtraction.GetAllAsText(bidiFlag, spacing, outBuffer);
+                    });
+            }
+
+            if(status == eSuccess && (writeToOutputFile || !quiet)) {
+                // writing each table to a separate CSV
+                vector<const Table*> tables;
+                TableListList::const_iterator itPages = tableExtraction.tablesForPages.begin();
+                for(; itPages != tableExtraction.tablesForPages.end(); ++itPages) {
+                    TableList::const_iterator itTables = itPages->begin();
+                    for(; itTables != itPages->end(); ++itTables)
+                        tables.push_back(&(*itTables));
                 }
+
+                status = WriteTablesResults(writeToOutputFile, outputFilePath, extractTextAndTables, tables.size(),
+                    [&tableExtraction, &tables, bidiFlag, spacing](size_t inTableIndex, OutputBuffer& outBuffer) {
+                        tableExtraction.GetTableAsCSVText(*tables[inTableIndex], bidiFlag, spacing, outBuffer);
+                    },
+                    [&tableExtraction, bidiFlag, spacing](OutputBuffer& outBuffer) {
+                        tableExtraction.GetAllAsCSVText(bidiFlag, spacing, outBuffer);
+                    });
             }
 
         } else {
             TextExtraction textExtraction;
+            textExtraction.SetFontPrefetchWorkers(fontPrefetchWorkers);
+            textExtraction.SetCompositionWorkers(compositionWorkers);
             status = textExtraction.ExtractText(filePath, startPage, endPage);
+            if(showMemoryStats)
+                ShowPageArenaStats(textExtraction.GetPageArenaStats());
 
             if(status != eSuccess) {
                 cerr << "Error: " << textExtraction.LatestError.description.c_str() << endl;
             }
-            ExtractionWarningList::iterator it = textExtraction.LatestWarnings.begin();
-            for(; it != textExtraction.LatestWarnings.end(); ++it) {
-                cerr << "Warning: " << it->description.c_str() << endl;
-            }    
-
-            if(status == eSuccess) {
-                if(writeToOutputFile) {
-                    ofstream outputFile(outputFilePath, ios::binary);
-                    if (!outputFile.is_open()) {
-                        cerr << "Error: Cannot open target file path for writing in" << outputFilePath.c_str() << endl;
-                        status = eFailure;
-                    }
-                    else {
-                        outputFile.write((const char*)scUTF8Bom, 3);
-                        textExtraction.GetResultsAsText(bidiFlag, spacing, outputFile);
-                        outputFile.close();
-                        cout <<"Wrote text to " << outputFilePath.c_str() << endl;
-                    }
+            ShowWarnings(textExtraction.LatestWarnings);
 
-                }
-                else if(!quiet) {
-                    textExtraction.GetResultsAsText(bidiFlag, spacing, cout);
-                }
+            if(status == eSuccess && (writeToOutputFile || !quiet)) {
+                status = WriteTextResults(writeToOutputFile, outputFilePath, reportTextToErrors,
+                    [&textExtraction, bidiFlag, spacing](OutputBuffer& outBuffer) {
+                        textExtraction.GetResultsAsText(bidiFlag, spacing, outBuffer);
+                    });
             }
         }
     }
 
 
     return  status == eSuccess ? 0:1;
-}
\ No newline at end of file
+}
@@ -0,0 +1,102 @@
+#include "AllPairsTablesLines.h"
+
+#include "lib/table-composition/TableComposer.h"
+
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+typedef vector<const ParsedLinePlacement*> ParsedLinePlacementPtrVector;
+typedef vector<size_t> SizeTVector;
+typedef vector<SizeTVector> SizeTVectorVector;
+
+static void ListLines(const ParsedLinePlacementList& inList, ParsedLinePlacementPtrVector& refLines) {
+    ParsedLinePlacementList::const_iterator it = inList.begin();
+    for(; it != inList.end(); ++it)
+        refLines.push_back(&(*it));
+}
+
+LinesList DetermineTablesLinesAllPairs(const Lines& inLines, const double (&inScopeBox)[4]) {
+    ParsedLinePlacementPtrVector horizontalLines;
+    ParsedLinePlacementPtrVector verticalLines;
+    LinesList result;
+
+    ListLines(inLines.horizontalLines, horizontalLines);
+    ListLines(inLines.verticalLines, verticalLines);
+
+    // lines are numbered horizontal lines first, and then vertical lines. same direction pairs are tested both ways, as they used to be
+    size_t horizontalCount = horizontalLines.size();
+    size_t linesCount = horizontalCount + verticalLines.size();
+    SizeTVectorVector connectedLines(linesCount);
+
+    for(size_t i = 0; i < horizontalCount; ++i) {
+        for(size_t j = 0; j < verticalLines.size(); ++j) {
+            if(HorizontalIntersectsWithVertical(*horizontalLines[i], *verticalLines[j], inScopeBox)) {
+                connectedLines[i].push_back(horizontalCount + j);
+                connectedLines[horizontalCount + j].push_back(i);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < horizontalCount; ++i) {
+        for(size_t j = 0; j < horizontalCount; ++j) {
+            if(i != j && HorizontalIntersectsWithHorizontal(*horizontalLines[i], *horizontalLines[j], inScopeBox)) {
+                connectedLines[i].push_back(j);
+                connectedLines[j].push_back(i);
+            }
+        }
+    }
+
+    for(size_t i = 0; i < verticalLines.size(); ++i) {
+        for(size_t j = 0; j < verticalLines.size(); ++j) {
+            if(i != j && VerticalIntersectsWithVertical(*verticalLines[i], *verticalLines[j], inScopeBox)) {
+                connectedLines[horizontalCount + i].push_back(horizontalCount + j);
+                connectedLines[horizontalCount + j].push_back(horizontalCount + i);
+            }
+        }
+    }
+
+    // number the connected groups by a breadth first search from each line not reached yet, so groups are ordered by their first line
+    static const size_t scNoGroup = (size_t)-1;
+    SizeTVector lineGroups(linesCount, scNoGroup);
+    size_t groupsCount = 0;
+    for(size_t i = 0; i < linesCount; ++i) {
+        if(lineGroups[i] != scNoGroup)
+            continue;
+        deque<size_t> toVisit;
+        lineGroups[i] = groupsCount;
+        toVisit.push_back(i);
+        while(!toVisit.empty()) {
+            const SizeTVector& lines = connectedLines[toVisit.front()];
+            toVisit.pop_front();
+            SizeTVector::const_iterator it = lines.begin();
+            for(; it != lines.end(); ++it) {
+                if(lineGroups[*it] == scNoGroup) {
+                    lineGroups[*it] = groupsCount;
+                    toVisit.push_back(*it);
+                }
+            }
+        }
+        ++groupsCount;
+    }
+
+    // lines keep the input order within groups
+    vector<Lines> groups(groupsCount);
+    for(size_t i = 0; i < linesCount; ++i) {
+        Lines& group = groups[lineGroups[i]];
+        const ParsedLinePlacement* line = i < horizontalCount ? horizontalLines[i] : verticalLines[i - horizontalCount];
+        if(line->isVertical)
+            group.verticalLines.push_back(*line);
+        else
+            group.horizontalLines.push_back(*line);
+    }
+
+    vector<Lines>::iterator itGroups = groups.begin();
+    for(; itGroups != groups.end(); ++itGroups) {
+        if(itGroups->horizontalLines.size() > 1 && itGroups->verticalLines.size() > 1)
+            result.push_back(move(*itGroups));
+    }
+
+    return result;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "lib/table-composition/Lines.h"
+
+/**
+ * DetermineTablesLines as it was before it found intersections with sweeps - testing every pair of lines with the intersection tests.
+ * Quadratic in the lines count, so it's only a reference, for checking and benchmarking DetermineTablesLines against.
+ */
+LinesList DetermineTablesLinesAllPairs(const Lines& inLines, const double (&inScopeBox)[4]);
@@ -0,0 +1,143 @@
+#include "EStatusCode.h"
+
+#include "TextExtraction.h"
+#include "TableExtraction.h"
+
+#include "TestPDFGenerator.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+/**
+ * Runs text and table extractions concurrently, each on an object of its own, and checks that their results are the same as when
+ * extracting one at a time. Some of the runs use font prefetch and composition workers as well. Build with USE_THREAD_SANITIZER
+ * to have races reported even when they don't change the results.
+ */
+
+static const unsigned int scThreadsCount = 8;
+static const unsigned int scRunsPerThread = 6;
+
+struct GeneratedFile {
+    string path;
+    unsigned long pagesCount;
+    unsigned long rowsCount;
+    unsigned long columnsCount;
+};
+
+typedef vector<GeneratedFile> GeneratedFileVector;
+
+enum EExtractionKind {
+    eExtractionKindText = 0,
+    eExtractionKindTables = 1
+};
+
+static EStatusCode ExtractAsString(const string& inFilePath, EExtractionKind inKind, unsigned int inWorkersCount, string& outResult) {
+    ostringstream stream;
+
+    if(inKind == eExtractionKindText) {
+        TextExtraction textExtraction;
+        textExtraction.SetFontPrefetchWorkers(inWorkersCount);
+        textExtraction.SetCompositionWorkers(inWorkersCount);
+        EStatusCode status = textExtraction.ExtractText(inFilePath);
+        if(status != eSuccess)
+            return status;
+        textExtraction.GetResultsAsText(-1, TextComposer::eSpacingBoth, stream);
+    } else {
+        TableExtraction tableExtraction;
+        tableExtraction.SetFontPrefetchWorkers(inWorkersCount);
+        tableExtraction.SetCompositionWorkers(inWorkersCount);
+        EStatusCode status = tableExtraction.ExtractTables(inFilePath);
+        if(status != eSuccess)
+            return status;
+        tableExtraction.GetAllAsCSVText(-1, TextComposer::eSpacingBoth, stream);
+    }
+
+    outResult = stream.str();
+    return eSuccess;
+}
+
+int ConcurrentExtractionTest(int argc, char* argv[]) {
+    if(argc < 2) {
+        cout << "Usage: ConcurrentExtractionTest <output directory>" << endl;
+        return 1;
+    }
+    string outputDirectory = argv[1];
+
+    // a few documents of different sizes, so concurrent runs are at different stages
+    GeneratedFileVector files;
+    GeneratedFile small = {outputDirectory + "/ConcurrentExtractionSmall.pdf", 1, 3, 3};
+    GeneratedFile medium = {outputDirectory + "/ConcurrentExtractionMedium.pdf", 4, 8, 5};
+    GeneratedFile large = {outputDirectory + "/ConcurrentExtractionLarge.pdf", 12, 20, 8};
+    files.push_back(small);
+    files.push_back(medium);
+    files.push_back(large);
+
+    // expected results, from extracting one at a time
+    vector<string> expectedTexts(files.size());
+    vector<string> expectedTables(files.size());
+    for(size_t i = 0; i < files.size(); ++i) {
+        if(!WriteTablesPDF(files[i].path, files[i].pagesCount, files[i].rowsCount, files[i].columnsCount)) {
+            cout << "Failed to write test PDF " << files[i].path << endl;
+            return 1;
+        }
+
+        if(ExtractAsString(files[i].path, eExtractionKindText, 0, expectedTexts[i]) != eSuccess ||
+            ExtractAsString(files[i].path, eExtractionKindTables, 0, expectedTables[i]) != eSuccess) {
+            cout << "Failed to extract " << files[i].path << endl;
+            return 1;
+        }
+
+        // make sure there's something to compare. the last page text and last cell should be in both
+        string lastPageTitle = "Page " + to_string(files[i].pagesCount) + " of " + to_string(files[i].pagesCount);
+        string lastCell = "P" + to_string(files[i].pagesCount) + "R" + to_string(files[i].rowsCount) + "C" + to_string(files[i].columnsCount);
+        if(expectedTexts[i].find(lastPageTitle) == string::npos || expectedTexts[i].find(lastCell) == string::npos) {
+            cout << "Text of " << files[i].path << " is missing expected texts. Got:\n" << expectedTexts[i] << endl;
+            return 1;
+        }
+        if(expectedTables[i].find(lastCell) == string::npos) {
+            cout << "Tables of " << files[i].path << " are missing expected cells. Got:\n" << expectedTables[i] << endl;
+            return 1;
+        }
+    }
+
+    // each thread goes over the files and kinds of extraction from a different starting point, with 0, 1 or 2 workers
+    vector<vector<string>> threadsFailures(scThreadsCount);
+    vector<thread> threads;
+    for(unsigned int t = 0; t < scThreadsCount; ++t) {
+        threads.push_back(thread([t, &files, &expectedTexts, &expectedTables, &threadsFailures]() {
+            unsigned int workersCount = t % 3;
+            for(unsigned int run = 0; run < scRunsPerThread; ++run) {
+                size_t fileIndex = (t + run) % files.size();
+                EExtractionKind kind = (EExtractionKind)((t + run / files.size()) % 2);
+                const string& expected = kind == eExtractionKindText ? expectedTexts[fileIndex] : expectedTables[fileIndex];
+
+                string result;
+                EStatusCode status = ExtractAsString(files[fileIndex].path, kind, workersCount, result);
+                if(status != eSuccess || result != expected) {
+                    threadsFailures[t].push_back(
+                        string(kind == eExtractionKindText ? "text" : "tables") + " of " + files[fileIndex].path + " with " +
+                        to_string(workersCount) + " workers " + (status != eSuccess ? "failed" : "differs from extracting alone")
+                    );
+                }
+            }
+        }));
+    }
+    for(size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    int failuresCount = 0;
+    for(size_t t = 0; t < threadsFailures.size(); ++t) {
+        for(size_t i = 0; i < threadsFailures[t].size(); ++i) {
+            cout << "Thread " << t << ": " << threadsFailures[t][i] << endl;
+            ++failuresCount;
+        }
+    }
+
+    return failuresCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include "lib/table-composition/TableComposer.h"
+
+#include "AllPairsTablesLines.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Checks that DetermineTablesLines, which finds candidate intersections with sweeps, groups lines the same as testing all pairs of
+ * lines does. Line sets are random, but made to hit the edge cases of the sweeps - lines on the same coordinates, continuations
+ * right around the intersection threshold, wide lines, scope boxes that cut through lines, unnormalized segments and NaNs.
+ */
+
+static const unsigned int scIterationsCount = 3000;
+static const unsigned int scMaxLinesPerDirection = 40;
+
+typedef mt19937 RandomGenerator;
+
+static double PickOne(RandomGenerator& refRandom, const vector<double>& inValues) {
+    return inValues[uniform_int_distribution<size_t>(0, inValues.size() - 1)(refRandom)];
+}
+
+static bool Chance(RandomGenerator& refRandom, double inProbability) {
+    return uniform_real_distribution<double>(0, 1)(refRandom) < inProbability;
+}
+
+// coordinates on a coarse lattice, so lines share coordinates often, and sometimes just off it
+static double RandomCoordinate(RandomGenerator& refRandom, double inStep) {
+    static const vector<double> scOffsets = {0, 0, 0, 0, 1e-7, -1e-7, 1, -1, 0.999999, 1.000001};
+    double value = uniform_int_distribution<int>(0, 40)(refRandom) * inStep + PickOne(refRandom, scOffsets);
+    if(Chance(refRandom, 0.01))
+        value = numeric_limits<double>::quiet_NaN();
+    return value;
+}
+
+static void RandomLineWidth(RandomGenerator& refRandom, double (&outWidth)[2]) {
+    static const vector<double> scWidths = {0, 0, 0.5, 1, 2.5, 10};
+    outWidth[0] = PickOne(refRandom, scWidths);
+    outWidth[1] = Chance(refRandom, 0.8) ? outWidth[0] : PickOne(refRandom, scWidths);
+}
+
+// lines along the same coordinate as a previous one, starting around its end
+static double ContinuationStart(RandomGenerator& refRandom, double inPreviousEnd) {
+    static const vector<double> scGaps = {-2, -1, -0.5, 0, 0.5, 1, 1.0000001, 0.9999999, 1.5, 3};
+    return inPreviousEnd + PickOne(refRandom, scGaps);
+}
+
+static void RandomLines(RandomGenerator& refRandom, Lines& outLines) {
+    static const vector<double> scSteps = {0.5, 1, 5, 10};
+    double step = PickOne(refRandom, scSteps);
+    size_t horizontalCount = uniform_int_distribution<size_t>(0, scMaxLinesPerDirection)(refRandom);
+    size_t verticalCount = uniform_int_distribution<size_t>(0, scMaxLinesPerDirection)(refRandom);
+
+    // horizontal lines go left to right
+    vector<ParsedLinePlacement> horizontalLines;
+    for(size_t i = 0; i < horizontalCount; ++i) {
+        double pointOne[2];
+        double pointTwo[2];
+        double width[2];
+        RandomLineWidth(refRandom, width);
+        if(!horizontalLines.empty() && Chance(refRandom, 0.3)) {
+            const ParsedLinePlacement& previous = horizontalLines[uniform_int_distribution<size_t>(0, horizontalLines.size() - 1)(refRandom)];
+            pointOne[1] = previous.globalPointOne[1];
+            pointOne[0] = ContinuationStart(refRandom, previous.globalPointTwo[0]);
+        } else {
+            pointOne[0] = RandomCoordinate(refRandom, step);
+            pointOne[1] = RandomCoordinate(refRandom, step);
+        }
+        pointTwo[0] = pointOne[0] + uniform_int_distribution<int>(0, 20)(refRandom) * step;
+        pointTwo[1] = pointOne[1];
+        if(Chance(refRandom, 0.05))
+            swap(pointOne[0], pointTwo[0]);
+        horizontalLines.push_back(ParsedLinePlacement(false, pointOne, pointTwo, width));
+    }
+
+    // vertical lines go top to bottom
+    vector<ParsedLinePlacement> verticalLines;
+    for(size_t i = 0; i < verticalCount; ++i) {
+        double pointOne[2];
+        double pointTwo[2];
+        double width[2];
+        RandomLineWidth(refRandom, width);
+        if(!verticalLines.empty() && Chance(refRandom, 0.3)) {
+            const ParsedLinePlacement& previous = verticalLines[uniform_int_distribution<size_t>(0, verticalLines.size() - 1)(refRandom)];
+            pointOne[0] = previous.globalPointOne[0];
+            pointOne[1] = -ContinuationStart(refRandom, -previous.globalPointTwo[1]);
+        } else {
+            pointOne[0] = RandomCoordinate(refRandom, step);
+            pointOne[1] = RandomCoordinate(refRandom, step);
+        }
+        pointTwo[0] = pointOne[0];
+        pointTwo[1] = pointOne[1] - uniform_int_distribution<int>(0, 20)(refRandom) * step;
+        if(Chance(refRandom, 0.05))
+            swap(pointOne[1], pointTwo[1]);
+        verticalLines.push_back(ParsedLinePlacement(true, pointOne, pointTwo, width));
+    }
+
+    outLines.horizontalLines.assign(horizontalLines.begin(), horizontalLines.end());
+    outLines.verticalLines.assign(verticalLines.begin(), verticalLines.end());
+}
+
+static void RandomScopeBox(RandomGenerator& refRandom, double (&outScopeBox)[4]) {
+    if(Chance(refRandom, 0.7)) {
+        // around everything
+        outScopeBox[0] = -1000;
+        outScopeBox[1] = -1000;
+        outScopeBox[2] = 1000;
+        outScopeBox[3] = 1000;
+        return;
+    }
+
+    // cutting through
+    double left = uniform_real_distribution<double>(-10, 200)(refRandom);
+    double bottom = uniform_real_distribution<double>(-10, 200)(refRandom);
+    outScopeBox[0] = left;
+    outScopeBox[1] = bottom;
+    outScopeBox[2] = left + uniform_real_distribution<double>(0, 300)(refRandom);
+    outScopeBox[3] = bottom + uniform_real_distribution<double>(0, 300)(refRandom);
+}
+
+// exact text of lines, hex floats so any difference shows
+static void AppendLines(const ParsedLinePlacementList& inLines, string& refText) {
+    char buffer[256];
+    ParsedLinePlacementList::const_iterator it = inLines.begin();
+    for(; it != inLines.end(); ++it) {
+        snprintf(buffer, sizeof(buffer), "  %s [%a %a] [%a %a] width [%a %a]\n",
+            it->isVertical ? "V" : "H",
+            it->globalPointOne[0], it->globalPointOne[1],
+            it->globalPointTwo[0], it->globalPointTwo[1],
+            it->effectiveLineWidth[0], it->effectiveLineWidth[1]);
+        refText.append(buffer);
+    }
+}
+
+static string TablesLinesToString(const LinesList& inTablesLines) {
+    string text;
+    LinesList::const_iterator it = inTablesLines.begin();
+    for(size_t i = 0; it != inTablesLines.end(); ++it, ++i) {
+        text.append("table " + to_string(i) + "\n");
+        AppendLines(it->horizontalLines, text);
+        AppendLines(it->verticalLines, text);
+    }
+    return text;
+}
+
+int TableLinesIntersectionTest(int argc, char* argv[]) {
+    size_t tablesCount = 0;
+
+    for(unsigned int i = 0; i < scIterationsCount; ++i) {
+        // seeded by the iteration, so a failure can be reproduced
+        RandomGenerator random(i);
+        Lines lines;
+        double scopeBox[4];
+        RandomLines(random, lines);
+        RandomScopeBox(random, scopeBox);
+
+        LinesList expected = DetermineTablesLinesAllPairs(lines, scopeBox);
+        LinesList result = DetermineTablesLines(lines, scopeBox);
+
+        string expectedText = TablesLinesToString(expected);
+        string resultText = TablesLinesToString(result);
+        if(expectedText != resultText) {
+            cout << "Iteration " << i << ": tables lines differ from testing all pairs.\nExpected:\n" << expectedText << "Got:\n" << resultText << endl;
+            return 1;
+        }
+        tablesCount += expected.size();
+    }
+
+    // make sure the line sets are not so sparse that there's nothing to compare
+    if(tablesCount < scIterationsCount / 10) {
+        cout << "Only " << tablesCount << " tables found in " << scIterationsCount << " line sets, expected more" << endl;
+        return 1;
+    }
+
+    return 0;
+}
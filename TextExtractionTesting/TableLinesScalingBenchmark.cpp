@@ -0,0 +1,115 @@
+#include "lib/table-composition/TableComposer.h"
+
+#include "AllPairsTablesLines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Times DetermineTablesLines on ruled grids of growing sizes, from 10x10 to 200x200 cells. Each cell edge is a segment of its own,
+ * as tables are often drawn, so an NxN grid has 2N(N+1) lines. With --all-pairs, testing all pairs of lines is timed too, for
+ * comparison - it's quadratic, so it takes a while on the bigger grids.
+ * Usage: TableLinesScalingBenchmark [--all-pairs] [repeats]
+ */
+
+static const size_t scGridSizes[] = {10, 25, 50, 100, 200};
+static const double scCellWidth = 20;
+static const double scCellHeight = 10;
+static const double scLineWidth = 0.5;
+
+typedef LinesList (*DetermineTablesLinesFunction)(const Lines& inLines, const double (&inScopeBox)[4]);
+
+static void BuildGrid(size_t inSize, Lines& outLines) {
+    double width[2] = {scLineWidth, scLineWidth};
+    double top = inSize * scCellHeight;
+
+    // top to bottom, left to right, as the lines would be drawn
+    for(size_t row = 0; row <= inSize; ++row) {
+        for(size_t column = 0; column < inSize; ++column) {
+            double pointOne[2] = {column * scCellWidth, top - row * scCellHeight};
+            double pointTwo[2] = {(column + 1) * scCellWidth, top - row * scCellHeight};
+            outLines.horizontalLines.push_back(ParsedLinePlacement(false, pointOne, pointTwo, width));
+        }
+    }
+    for(size_t column = 0; column <= inSize; ++column) {
+        for(size_t row = 0; row < inSize; ++row) {
+            double pointOne[2] = {column * scCellWidth, top - row * scCellHeight};
+            double pointTwo[2] = {column * scCellWidth, top - (row + 1) * scCellHeight};
+            outLines.verticalLines.push_back(ParsedLinePlacement(true, pointOne, pointTwo, width));
+        }
+    }
+}
+
+// best of the repeats, in milliseconds. fails if the grid doesn't come out as a single table of all lines
+static bool TimeDetermineTablesLines(DetermineTablesLinesFunction inFunction, const Lines& inLines, const double (&inScopeBox)[4],
+    unsigned int inRepeats, double& outMilliseconds) {
+    outMilliseconds = -1;
+    for(unsigned int i = 0; i < inRepeats; ++i) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        LinesList tablesLines = inFunction(inLines, inScopeBox);
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        if(tablesLines.size() != 1 ||
+            tablesLines.front().horizontalLines.size() != inLines.horizontalLines.size() ||
+            tablesLines.front().verticalLines.size() != inLines.verticalLines.size())
+            return false;
+
+        if(outMilliseconds < 0 || milliseconds < outMilliseconds)
+            outMilliseconds = milliseconds;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool allPairs = false;
+    unsigned int repeats = 3;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--all-pairs") == 0)
+            allPairs = true;
+        else if(atoi(argv[i]) > 0)
+            repeats = (unsigned int)atoi(argv[i]);
+        else {
+            printf("Usage: %s [--all-pairs] [repeats]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-10s %10s %14s", "grid", "lines", "sweeps ms");
+    if(allPairs)
+        printf(" %14s %10s", "all pairs ms", "speedup");
+    printf("\n");
+
+    for(size_t i = 0; i < sizeof(scGridSizes) / sizeof(size_t); ++i) {
+        size_t size = scGridSizes[i];
+        Lines lines;
+        BuildGrid(size, lines);
+        double scopeBox[4] = {-scCellWidth, -scCellHeight, (size + 1) * scCellWidth, (size + 1) * scCellHeight};
+
+        double sweepsMilliseconds;
+        if(!TimeDetermineTablesLines(DetermineTablesLines, lines, scopeBox, repeats, sweepsMilliseconds)) {
+            printf("%zux%zu grid did not come out as a single table\n", size, size);
+            return 1;
+        }
+
+        char grid[32];
+        snprintf(grid, sizeof(grid), "%zux%zu", size, size);
+        printf("%-10s %10zu %14.2f", grid, lines.horizontalLines.size() + lines.verticalLines.size(), sweepsMilliseconds);
+        if(allPairs) {
+            double allPairsMilliseconds;
+            if(!TimeDetermineTablesLines(DetermineTablesLinesAllPairs, lines, scopeBox, 1, allPairsMilliseconds)) {
+                printf("\n%zux%zu grid did not come out as a single table testing all pairs\n", size, size);
+                return 1;
+            }
+            printf(" %14.2f %9.1fx", allPairsMilliseconds, allPairsMilliseconds / sweepsMilliseconds);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    return 0;
+}
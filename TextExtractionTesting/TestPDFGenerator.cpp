@@ -0,0 +1,102 @@
+#include "TestPDFGenerator.h"
+
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+static const double scPageWidth = 612;
+static const double scPageHeight = 792;
+static const double scTableLeft = 50;
+static const double scTableTop = 720;
+static const double scTableWidth = 500;
+static const double scTableHeight = 600;
+
+// catalog, pages and font come first, then each page is followed by its content stream
+static const unsigned long scCatalogObject = 1;
+static const unsigned long scPagesObject = 2;
+static const unsigned long scFontObject = 3;
+static const unsigned long scFirstPageObject = 4;
+
+static string ComposePageContent(unsigned long inPageNumber, unsigned long inPagesCount, unsigned long inRowsCount, unsigned long inColumnsCount) {
+    ostringstream content;
+    double rowHeight = scTableHeight / inRowsCount;
+    double columnWidth = scTableWidth / inColumnsCount;
+
+    content << "BT /F1 14 Tf " << scTableLeft << " " << scTableTop + 30 << " Td (Page " << inPageNumber << " of " << inPagesCount << ") Tj ET\n";
+
+    // the grid lines, as stroked segments
+    content << "0.5 w\n";
+    for(unsigned long i = 0; i <= inRowsCount; ++i) {
+        double y = scTableTop - i * rowHeight;
+        content << scTableLeft << " " << y << " m " << scTableLeft + scTableWidth << " " << y << " l S\n";
+    }
+    for(unsigned long i = 0; i <= inColumnsCount; ++i) {
+        double x = scTableLeft + i * columnWidth;
+        content << x << " " << scTableTop << " m " << x << " " << scTableTop - scTableHeight << " l S\n";
+    }
+
+    // cell texts, at the bottom left of the cells
+    for(unsigned long row = 0; row < inRowsCount; ++row) {
+        for(unsigned long column = 0; column < inColumnsCount; ++column) {
+            content << "BT /F1 8 Tf " << scTableLeft + column * columnWidth + 3 << " " << scTableTop - (row + 1) * rowHeight + 4
+                    << " Td (P" << inPageNumber << "R" << row + 1 << "C" << column + 1 << ") Tj ET\n";
+        }
+    }
+
+    return content.str();
+}
+
+bool WriteTablesPDF(const string& inFilePath, unsigned long inPagesCount, unsigned long inRowsCount, unsigned long inColumnsCount) {
+    if(inPagesCount == 0 || inRowsCount == 0 || inColumnsCount == 0)
+        return false;
+
+    ostringstream pdf;
+    unsigned long objectsCount = scFirstPageObject + 2 * inPagesCount;
+    vector<size_t> offsets(objectsCount, 0);
+
+    pdf << "%PDF-1.4\n";
+
+    offsets[scCatalogObject] = (size_t)pdf.tellp();
+    pdf << scCatalogObject << " 0 obj\n<< /Type /Catalog /Pages " << scPagesObject << " 0 R >>\nendobj\n";
+
+    offsets[scPagesObject] = (size_t)pdf.tellp();
+    pdf << scPagesObject << " 0 obj\n<< /Type /Pages /Kids [";
+    for(unsigned long i = 0; i < inPagesCount; ++i)
+        pdf << " " << scFirstPageObject + 2 * i << " 0 R";
+    pdf << " ] /Count " << inPagesCount << " >>\nendobj\n";
+
+    offsets[scFontObject] = (size_t)pdf.tellp();
+    pdf << scFontObject << " 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>\nendobj\n";
+
+    for(unsigned long i = 0; i < inPagesCount; ++i) {
+        unsigned long pageObject = scFirstPageObject + 2 * i;
+        unsigned long contentObject = pageObject + 1;
+
+        offsets[pageObject] = (size_t)pdf.tellp();
+        pdf << pageObject << " 0 obj\n<< /Type /Page /Parent " << scPagesObject << " 0 R /MediaBox [0 0 " << scPageWidth << " " << scPageHeight
+            << "] /Resources << /Font << /F1 " << scFontObject << " 0 R >> >> /Contents " << contentObject << " 0 R >>\nendobj\n";
+
+        string content = ComposePageContent(i + 1, inPagesCount, inRowsCount, inColumnsCount);
+        offsets[contentObject] = (size_t)pdf.tellp();
+        pdf << contentObject << " 0 obj\n<< /Length " << content.size() << " >>\nstream\n" << content << "\nendstream\nendobj\n";
+    }
+
+    // xref entries are 20 bytes each, end of line included
+    size_t xrefOffset = (size_t)pdf.tellp();
+    pdf << "xref\n0 " << objectsCount << "\n";
+    pdf << "0000000000 65535 f \n";
+    char entry[21];
+    for(unsigned long i = 1; i < objectsCount; ++i) {
+        snprintf(entry, sizeof(entry), "%010lu 00000 n \n", (unsigned long)offsets[i]);
+        pdf << entry;
+    }
+    pdf << "trailer\n<< /Size " << objectsCount << " /Root " << scCatalogObject << " 0 R >>\nstartxref\n" << xrefOffset << "\n%%EOF\n";
+
+    ofstream file(inFilePath.c_str(), ios::binary | ios::trunc);
+    file << pdf.str();
+    file.close();
+    return !file.fail();
+}
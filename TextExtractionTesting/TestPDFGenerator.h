@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Writes small PDFs for tests, so tests don't need materials checked in. Each page has a title line, and a ruled grid table with a
+ * text in each cell - "P<page>R<row>C<column>", all 1 based. Texts are in Helvetica (a standard font, so nothing is embedded), and
+ * content streams are not compressed.
+ */
+bool WriteTablesPDF(const std::string& inFilePath, unsigned long inPagesCount, unsigned long inRowsCount, unsigned long inColumnsCount);